@@ -0,0 +1,160 @@
+#include "arena.h"
+#include "watchdog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#	include <sys/mman.h>
+#endif
+
+const size_t arena_alignment = alignof( std::max_align_t );
+const size_t huge_page_size = size_t( 2 ) << 20;
+const size_t min_region_size = huge_page_size;
+const size_t min_overflow_size = size_t( 1 ) << 20;
+
+std::atomic< uint64_t > reserved_bytes{ 0 };
+std::atomic< uint64_t > peak_reserved_bytes{ 0 };
+std::atomic< uint64_t > high_water_bytes{ 0 };
+std::atomic< uint64_t > region_count{ 0 };
+std::atomic< uint64_t > huge_page_region_count{ 0 };
+std::atomic< uint64_t > overflow_count{ 0 };
+
+void update_max( std::atomic< uint64_t >& value, uint64_t v )
+{
+	auto cur = value.load( std::memory_order_relaxed );
+	while ( v > cur && !value.compare_exchange_weak( cur, v, std::memory_order_relaxed ) ) {}
+}
+
+size_t round_up( size_t size, size_t multiple ) { return ( size + multiple - 1 ) / multiple * multiple; }
+
+arena::~arena()
+{
+	for ( auto& r : overflow_ )
+		release_region( r );
+	release_region( main_ );
+}
+
+void* arena::allocate( size_t size )
+{
+	size = round_up( std::max< size_t >( size, 1 ), arena_alignment );
+	if ( !main_.data )
+		main_ = reserve_region( min_region_size );
+	if ( main_.size - used_ >= size )
+	{
+		auto* p = main_.data + used_;
+		used_ += size;
+		return p;
+	}
+
+	// doesn't fit, continue in an overflow block until the next reset
+	if ( overflow_.empty() || overflow_.back().size - overflow_used_ < size )
+	{
+		overflow_.push_back( reserve_region( std::max( size, min_overflow_size ) ) );
+		overflow_used_ = 0;
+	}
+	auto* p = overflow_.back().data + overflow_used_;
+	overflow_used_ += size;
+	overflow_total_ += size;
+	return p;
+}
+
+void arena::reset()
+{
+	auto used = used_ + overflow_total_;
+	update_max( high_water_bytes, used );
+	if ( !overflow_.empty() )
+	{
+		// grow the region to fit this file in one piece next time
+		overflow_count.fetch_add( 1, std::memory_order_relaxed );
+		for ( auto& r : overflow_ )
+			release_region( r );
+		overflow_.clear();
+		release_region( main_ );
+		main_ = reserve_region( used + used / 4 );
+	}
+	used_ = overflow_used_ = overflow_total_ = 0;
+}
+
+arena& arena::local()
+{
+	thread_local arena a;
+	return a;
+}
+
+arena::statistics arena::stats()
+{
+	statistics s;
+	s.peak_reserved = peak_reserved_bytes;
+	s.high_water = high_water_bytes;
+	s.regions = region_count;
+	s.huge_page_regions = huge_page_region_count;
+	s.overflows = overflow_count;
+	return s;
+}
+
+arena::region arena::reserve_region( size_t size )
+{
+	region r;
+	r.size = round_up( std::max( size, min_region_size ), huge_page_size );
+#ifndef _WIN32
+	void* p = MAP_FAILED;
+#	ifdef MAP_HUGETLB
+	// explicit huge pages only work if the system has reserved them
+	p = mmap( nullptr, r.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+	if ( p != MAP_FAILED )
+		huge_page_region_count.fetch_add( 1, std::memory_order_relaxed );
+#	endif
+	if ( p == MAP_FAILED )
+	{
+		p = mmap( nullptr, r.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+#	ifdef MADV_HUGEPAGE
+		// otherwise ask for transparent huge pages
+		if ( p != MAP_FAILED && madvise( p, r.size, MADV_HUGEPAGE ) == 0 )
+			huge_page_region_count.fetch_add( 1, std::memory_order_relaxed );
+#	endif
+	}
+	if ( p != MAP_FAILED )
+	{
+		r.data = static_cast< char* >( p );
+		r.mapped = true;
+	}
+#endif
+	if ( !r.data )
+	{
+		r.data = static_cast< char* >( std::malloc( r.size ) );
+		if ( !r.data )
+			throw std::bad_alloc();
+	}
+	region_count.fetch_add( 1, std::memory_order_relaxed );
+	update_max( peak_reserved_bytes, reserved_bytes.fetch_add( r.size, std::memory_order_relaxed ) + r.size );
+	return r;
+}
+
+void arena::release_region( region& r )
+{
+	if ( !r.data )
+		return;
+	reserved_bytes.fetch_sub( r.size, std::memory_order_relaxed );
+#ifndef _WIN32
+	if ( r.mapped )
+		munmap( r.data, r.size );
+	else
+#endif
+		std::free( r.data );
+	r = region();
+}
+
+void* arena_allocate( size_t size )
+{
+	// rapidxml requests a block per 64 KB of DOM, which makes this a checkpoint for parsing large files
+	check_cancelled();
+	return arena::local().allocate( size );
+}
+
+void arena_free( void* )
+{
+	// arena memory is released by arena::reset()
+}
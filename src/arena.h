@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Bump allocator for memory that lives only while a single file is converted, such as the rapidxml DOM.
+/// Memory is taken from one large region, backed by huge pages where available, and released by reset() in O(1).
+/// If a file needs more than the region holds, overflow blocks are used and the region is grown at the next reset,
+/// so the region adapts to the largest file seen so far.
+class arena
+{
+public:
+	struct statistics
+	{
+		uint64_t peak_reserved = 0; // peak bytes reserved by all arenas together
+		uint64_t high_water = 0; // largest number of bytes used by a single file
+		uint64_t regions = 0; // number of regions and overflow blocks reserved
+		uint64_t huge_page_regions = 0; // number of those backed by huge pages
+		uint64_t overflows = 0; // files that did not fit in their arena's region
+	};
+
+	arena() = default;
+	arena( const arena& ) = delete;
+	arena& operator=( const arena& ) = delete;
+	~arena();
+
+	/// Allocate size bytes, aligned for any type.
+	void* allocate( size_t size );
+
+	/// Release all allocations.
+	void reset();
+
+	/// Arena of the current thread.
+	static arena& local();
+
+	/// Statistics over all arenas of the run.
+	static statistics stats();
+
+private:
+	struct region
+	{
+		char* data = nullptr;
+		size_t size = 0;
+		bool mapped = false;
+	};
+	static region reserve_region( size_t size );
+	static void release_region( region& r );
+
+	region main_;
+	size_t used_ = 0;
+	std::vector< region > overflow_;
+	size_t overflow_used_ = 0; // bytes used in the last overflow block
+	size_t overflow_total_ = 0; // bytes used in all overflow blocks
+};
+
+/// Allocation functions for xml_document::set_allocator(), using arena::local().
+/// arena_allocate() is a cancellation checkpoint and may throw conversion_timeout.
+void* arena_allocate( size_t size );
+void arena_free( void* );
+
+/// Resets the arena of the current thread when it goes out of scope.
+struct arena_scope
+{
+	arena_scope() = default;
+	arena_scope( const arena_scope& ) = delete;
+	arena_scope& operator=( const arena_scope& ) = delete;
+	~arena_scope() { arena::local().reset(); }
+};
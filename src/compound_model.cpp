@@ -0,0 +1,170 @@
+#include "compound_model.h"
+
+#include "rapidxml.hpp"
+#include "xo/string/string_tools.h"
+#include "xo/utility/hash.h"
+#include "xml_text.h"
+#include "watchdog.h"
+
+using namespace xo;
+using namespace rapidxml;
+using std::string, std::string_view;
+
+string_view node_name( xml_node<>* node ) {
+	return string_view( node->name(), node->name_size() );
+}
+
+void append_text( string& str, xml_node<>* node ) {
+	append_decoded( str, node->value(), node->value() + node->value_size() );
+}
+
+void extract_ref( string& result, xml_node<>* node )
+{
+	if ( auto* id = node->first_attribute( "refid" ) )
+	{
+		result += char( text_code::link_open );
+		append_decoded( result, id->value(), id->value() + id->value_size() );
+		result += char( text_code::link_text );
+		append_text( result, node );
+		result += char( text_code::link_close );
+	}
+}
+
+void extract_text( string& result, xml_node<>* node );
+
+void extract_markup( string& result, text_markup m, xml_node<>* node )
+{
+	result += char( text_code::markup_open );
+	result += char( m );
+	extract_text( result, node );
+	result += char( text_code::markup_close );
+	result += char( m );
+}
+
+void extract_text( string& result, xml_node<>* node )
+{
+	for ( xml_node<>* child = node->first_node(); child; child = child->next_sibling() )
+	{
+		if ( child->type() == node_element )
+		{
+			auto name = string( child->name() );
+			switch ( xo::hash( name ) )
+			{
+			case "para"_hash: extract_text( result, child ); break;
+			case "ref"_hash: extract_ref( result, child ); break;
+			case "emphasis"_hash: extract_markup( result, text_markup::emphasis, child ); break;
+			case "bold"_hash: extract_markup( result, text_markup::bold, child ); break;
+			case "subscript"_hash: extract_markup( result, text_markup::subscript, child ); break;
+			case "verbatim"_hash: extract_markup( result, text_markup::verbatim, child ); break;
+			case "itemizedlist"_hash: extract_markup( result, text_markup::list, child ); break;
+			case "listitem"_hash: extract_markup( result, text_markup::list_item, child ); break;
+			}
+		}
+		else append_text( result, child );
+	}
+}
+
+// fills the model in a single walk over the compounddef, reusing one text buffer
+struct compound_extractor
+{
+	compound_model& m;
+	string buf;
+
+	pool_string add_text( xml_node<>* node ) {
+		buf.clear();
+		if ( node )
+			extract_text( buf, node );
+		return m.strings.add( buf );
+	}
+
+	pool_string add_plain_text( xml_node<>* node ) {
+		buf.clear();
+		if ( node )
+			append_text( buf, node );
+		return m.strings.add( buf );
+	}
+
+	pool_string add_ref( xml_node<>* node ) {
+		buf.clear();
+		extract_ref( buf, node );
+		return m.strings.add( buf );
+	}
+
+	// members is null for sections without a table, whose members are only added by name
+	void add_member( member_table* members, xml_node<>* member )
+	{
+		check_cancelled();
+		xml_node<>* name = nullptr, *type = nullptr, *args = nullptr, *brief = nullptr;
+		for ( auto* child = member->first_node(); child; child = child->next_sibling() )
+		{
+			auto n = node_name( child );
+			if ( n == "name" ) name = child;
+			else if ( n == "type" ) type = child;
+			else if ( n == "argsstring" ) args = child;
+			else if ( n == "briefdescription" ) brief = child;
+		}
+
+		buf.clear();
+		if ( brief && members )
+			extract_text( buf, brief );
+		if ( buf.find_first_not_of( " \t\r\n" ) == string::npos )
+		{
+			if ( name )
+				m.other_members.push_back( add_plain_text( name ) );
+			return;
+		}
+
+		auto brief_str = m.strings.add( buf );
+		members->push_back( add_plain_text( name ), add_text( type ), add_text( args ), brief_str );
+	}
+
+	void add_section( xml_node<>* section )
+	{
+		auto* kind_attr = section->first_attribute( "kind" );
+		if ( !kind_attr )
+			return;
+		auto kind = string_view( kind_attr->value(), kind_attr->value_size() );
+		member_table* members = nullptr;
+		if ( kind == "public-attrib" )
+			members = &m.attributes;
+		else if ( kind == "public-func" || kind == "public-static-func" )
+			members = &m.functions;
+		else if ( kind == "friend" || kind == "related" )
+			return; // not members of the compound
+
+		for ( auto* member = section->first_node(); member; member = member->next_sibling() )
+			if ( node_name( member ) == "memberdef" )
+				add_member( members, member );
+	}
+
+	void add_compound( xml_node<>* root )
+	{
+		for ( auto* child = root->first_node(); child; child = child->next_sibling() )
+		{
+			auto n = node_name( child );
+			if ( n == "sectiondef" )
+				add_section( child );
+			else if ( n == "compoundname" )
+				m.name = m.strings.add( xo::tidy_type_name( decode_text( child->value(), child->value() + child->value_size() ) ) );
+			else if ( n == "briefdescription" )
+				m.brief = add_text( child );
+			else if ( n == "detaileddescription" )
+				m.detailed = add_text( child );
+			else if ( n == "basecompoundref" && child->first_attribute( "refid" ) )
+			{
+				m.bases.push_back( add_ref( child ) );
+				auto* prot = child->first_attribute( "prot" );
+				m.base_protection.push_back( m.strings.add( prot ? string_view( prot->value(), prot->value_size() ) : "public" ) );
+			}
+			else if ( n == "derivedcompoundref" && child->first_attribute( "refid" ) )
+				m.derived.push_back( add_ref( child ) );
+		}
+	}
+};
+
+compound_model extract_compound( xml_node<>* root )
+{
+	compound_model m;
+	compound_extractor{ m, {} }.add_compound( root );
+	return m;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "string_pool.h"
+
+namespace rapidxml { template< class Ch > class xml_node; }
+
+/// Text in the compound model is format-neutral: markup and links are stored as control codes
+/// (which cannot occur in XML text) and are translated by an emitter when a page is rendered.
+/// Links are stored as link_open, refid, link_text, text, link_close.
+enum class text_code : char { markup_open = '\x01', markup_close = '\x02', link_open = '\x03', link_text = '\x04', link_close = '\x05' };
+
+/// Markup kind, follows markup_open and markup_close.
+enum class text_markup : char { emphasis = 'e', bold = 'b', subscript = 's', verbatim = 'v', list = 'l', list_item = 'i' };
+
+/// Members of a compound, stored as contiguous columns.
+struct member_table
+{
+	std::vector< pool_string > name;
+	std::vector< pool_string > type;
+	std::vector< pool_string > args;
+	std::vector< pool_string > brief;
+
+	size_t size() const { return name.size(); }
+	void push_back( pool_string n, pool_string t, pool_string a, pool_string b ) {
+		name.push_back( n ); type.push_back( t ); args.push_back( a ); brief.push_back( b );
+	}
+};
+
+/// Everything needed to render the page of a class or struct, independent of output format and settings.
+/// All text is stored in a single string pool.
+struct compound_model
+{
+	string_pool strings;
+	pool_string name;
+	pool_string brief;
+	pool_string detailed;
+	std::vector< pool_string > bases;
+	std::vector< pool_string > base_protection; // public, protected or private, for each base
+	std::vector< pool_string > derived;
+	member_table attributes;
+	member_table functions;
+	std::vector< pool_string > other_members; // names of members that are not in the tables, which still hide inherited members
+
+	std::string_view str( pool_string s ) const { return strings[ s ]; }
+};
+
+/// Extract the model from a compounddef node in a single pass, members without brief description are skipped.
+compound_model extract_compound( rapidxml::xml_node< char >* compounddef );
@@ -0,0 +1,282 @@
+#include "conversion.h"
+#include "result_log.h"
+
+#include "work_queue.h"
+#include "tar_reader.h"
+#include "dir_walker.h"
+#include "watchdog.h"
+#include "inheritance_graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include "xo/system/log.h"
+#include "xo/string/string_tools.h"
+
+using namespace xo;
+using std::string;
+
+bool is_input_file( const xo::path& input_path )
+{
+	auto filename = input_path.filename().str();
+	if ( input_path.extension_no_dot() != "xml" )
+		return false;
+	return str_begins_with( filename, "class" ) || str_begins_with( filename, "struct" );
+}
+
+std::vector< xo::path > find_input_files( const xo::path& input_dir )
+{
+	std::vector< xo::path > files;
+	for ( auto& e : std::filesystem::directory_iterator( input_dir.str() ) )
+	{
+		auto input_path = xo::path( e.path().string() );
+		if ( is_input_file( input_path ) )
+			files.emplace_back( input_path );
+	}
+
+	// directory_iterator order depends on the file system
+	std::sort( files.begin(), files.end(), []( const xo::path& a, const xo::path& b ) { return a.str() < b.str(); } );
+	return files;
+}
+
+struct work_item
+{
+	size_t index;
+	conversion_item item;
+	conversion_result* result;
+};
+
+int worker_count( const conversion_settings& run )
+{
+	return std::max( run.num_threads > 0 ? run.num_threads : int( std::thread::hardware_concurrency() ), 1 );
+}
+
+void convert_item( conversion_item& item, conversion_result& r, const dokugen_settings& cfg )
+{
+	r.input = item.input;
+	try
+	{
+		// conversion failures are returned, only timeouts and unexpected errors such as bad_alloc are thrown
+		auto elements = item.has_contents ? write_doku( item.input, item.contents, cfg ) : write_doku( item.input, cfg );
+		if ( elements )
+		{
+			r.elements = *elements;
+			r.converted = true;
+		}
+		else
+		{
+			r.error_code = elements.failure().code;
+			r.error = elements.failure().message;
+		}
+	}
+	catch ( conversion_timeout& )
+	{
+		r.error_code = conversion_error::timed_out;
+	}
+	catch ( std::exception& e )
+	{
+		r.error_code = conversion_error::unexpected;
+		r.error = e.what();
+	}
+}
+
+std::vector< conversion_result > convert_stream( const std::function< void( const conversion_sink& ) >& produce,
+	const dokugen_settings& cfg, const conversion_settings& run, bool sort_by_input )
+{
+	auto num_threads = worker_count( run );
+
+	// results are added by the producer, a deque keeps references to them valid while it grows
+	std::deque< conversion_result > results;
+	work_queue< work_item > queue( 4 * num_threads );
+	result_log rlog( num_threads, run.quiet, sort_by_input );
+	watchdog wd( num_threads, run.file_timeout );
+
+	// the producer runs ahead of the workers, until the queue is full
+	std::exception_ptr producer_error;
+	std::mutex results_mutex;
+	std::thread producer( [&]() {
+		try
+		{
+			produce( [&]( conversion_item&& item ) {
+				std::unique_lock< std::mutex > lock( results_mutex );
+				auto idx = results.size();
+				auto* r = &results.emplace_back();
+				lock.unlock();
+				queue.push( work_item{ idx, std::move( item ), r } );
+			} );
+		}
+		catch ( ... )
+		{
+			producer_error = std::current_exception();
+		}
+		queue.close();
+	} );
+
+	auto worker = [&]( size_t worker_idx ) {
+		for ( work_item w; queue.pop( w ); )
+		{
+			wd.start( worker_idx );
+			convert_item( w.item, *w.result, cfg );
+			w.result->duration = wd.stop( worker_idx );
+			if ( w.result->error_code == conversion_error::timed_out )
+				w.result->error = "Timed out after " + std::to_string( w.result->duration ) + " seconds";
+			w.item.contents = string();
+			rlog.post( worker_idx, w.index, w.result );
+		}
+	};
+
+	std::vector< std::thread > threads;
+	for ( int i = 0; i < num_threads; ++i )
+		threads.emplace_back( worker, i );
+	producer.join();
+	for ( auto& t : threads )
+		t.join();
+	rlog.finish( results.size() );
+
+	if ( producer_error )
+		std::rethrow_exception( producer_error );
+
+	std::vector< conversion_result > result_vec( std::make_move_iterator( results.begin() ), std::make_move_iterator( results.end() ) );
+	if ( sort_by_input )
+		std::stable_sort( result_vec.begin(), result_vec.end(), []( const conversion_result& a, const conversion_result& b ) { return a.input.str() < b.input.str(); } );
+	return result_vec;
+}
+
+std::vector< conversion_result > convert_files( const std::vector< xo::path >& files, const dokugen_settings& cfg, const conversion_settings& run )
+{
+	auto produce = [&]( const conversion_sink& sink ) {
+		for ( auto& f : files )
+			sink( conversion_item{ f, string(), false } );
+	};
+	return convert_stream( produce, cfg, run );
+}
+
+std::vector< conversion_result > convert_tree( const xo::path& input_dir, const dokugen_settings& cfg, const conversion_settings& run,
+	const std::function< bool( const xo::path& ) >& select )
+{
+	// discovery order depends on thread timing, so results are sorted afterwards
+	auto produce = [&]( const conversion_sink& sink ) {
+		auto walk_threads = std::clamp( run.num_threads > 0 ? run.num_threads : int( std::thread::hardware_concurrency() ), 1, 16 );
+		walk_input_files( input_dir, walk_threads, [&]( const path& file ) {
+			if ( !select || select( file ) )
+				sink( conversion_item{ file, string(), false } );
+		} );
+	};
+	return convert_stream( produce, cfg, run, true );
+}
+
+std::vector< conversion_result > convert_tar( std::istream& tar_stream, const dokugen_settings& cfg, const conversion_settings& run,
+	const std::function< bool( const std::string& ) >& select )
+{
+	auto produce = [&]( const conversion_sink& sink ) {
+		tar_reader tar( tar_stream );
+		auto is_selected = [&]( const string& name ) { return is_input_file( path( name ) ) && ( !select || select( name ) ); };
+		string name, contents;
+		while ( tar.next( name, contents, is_selected ) )
+			sink( conversion_item{ path( name ), std::move( contents ), true } );
+	};
+	return convert_stream( produce, cfg, run );
+}
+
+conversion_pool::conversion_pool( const conversion_settings& run ) :
+	queue_( 4 * worker_count( run ) ),
+	watchdog_( worker_count( run ), run.file_timeout )
+{
+	for ( int i = 0; i < worker_count( run ); ++i )
+		threads_.emplace_back( &conversion_pool::run_worker, this, i );
+}
+
+conversion_pool::~conversion_pool()
+{
+	queue_.close();
+	for ( auto& t : threads_ )
+		t.join();
+}
+
+std::vector< conversion_result > conversion_pool::convert( const std::vector< xo::path >& files, const dokugen_settings& cfg )
+{
+	std::vector< conversion_result > results( files.size() );
+	batch b;
+	b.remaining = files.size();
+	for ( size_t i = 0; i < files.size(); ++i )
+		queue_.push( job{ files[ i ], &cfg, &results[ i ], &b } );
+
+	std::unique_lock< std::mutex > lock( b.mutex );
+	b.done.wait( lock, [&]() { return b.remaining == 0; } );
+	return results;
+}
+
+void conversion_pool::run_worker( size_t worker_idx )
+{
+	for ( job j; queue_.pop( j ); )
+	{
+		conversion_item item{ j.input, string(), false };
+		watchdog_.start( worker_idx );
+		convert_item( item, *j.result, *j.cfg );
+		j.result->duration = watchdog_.stop( worker_idx );
+		if ( j.result->error_code == conversion_error::timed_out )
+			j.result->error = "Timed out after " + std::to_string( j.result->duration ) + " seconds";
+
+		std::lock_guard< std::mutex > lock( j.owner->mutex );
+		if ( --j.owner->remaining == 0 )
+			j.owner->done.notify_all();
+	}
+}
+
+std::shared_ptr< const inheritance_graph > build_inheritance_graph( const std::vector< xo::path >& files,
+	const dokugen_settings& cfg, const conversion_settings& run )
+{
+	// each thread takes the next file, entries are stored by file index so the graph doesn't depend on timing
+	std::vector< inheritance_graph::compound_entry > entries( files.size() );
+	std::atomic< size_t > next{ 0 };
+	auto num_threads = worker_count( run );
+	watchdog wd( num_threads, run.file_timeout );
+	auto read_entries = [&]( size_t worker_idx ) {
+		for ( size_t i; ( i = next++ ) < files.size(); )
+		{
+			// compounds that cannot be read in time are left out here, their conversion reports the error
+			wd.start( worker_idx );
+			try
+			{
+				auto contents = read_input_file( files[ i ] );
+				if ( contents )
+				{
+					auto m = load_compound( *contents, cfg );
+					auto refid = files[ i ].filename().str();
+					if ( m )
+						entries[ i ] = inheritance_graph::make_entry( refid.substr( 0, refid.rfind( '.' ) ), *m );
+				}
+			}
+			catch ( std::exception& ) {}
+			wd.stop( worker_idx );
+		}
+	};
+	std::vector< std::thread > threads;
+	for ( int i = 1; i < num_threads; ++i )
+		threads.emplace_back( read_entries, size_t( i ) );
+	read_entries( 0 );
+	for ( auto& t : threads )
+		t.join();
+
+	return std::make_shared< inheritance_graph >( entries );
+}
+
+conversion_summary summarize( const std::vector< conversion_result >& results )
+{
+	conversion_summary s;
+	for ( auto& r : results )
+	{
+		if ( r.converted )
+		{
+			++s.converted;
+			s.elements += r.elements;
+		}
+		else ++s.failed;
+		++s.errors[ size_t( r.error_code ) ];
+	}
+	return s;
+}
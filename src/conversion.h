@@ -0,0 +1,117 @@
+#pragma once
+
+#include "dokugen.h"
+#include "work_queue.h"
+#include "watchdog.h"
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct conversion_result
+{
+	xo::path input;
+	int elements = 0;
+	bool converted = false;
+	conversion_error error_code = conversion_error::none;
+	double duration = 0;
+	std::string error;
+};
+
+struct conversion_settings
+{
+	int num_threads = 0;
+	bool quiet = false;
+	double file_timeout = 0; // time budget per file in seconds, zero for no limit
+};
+
+/// Number of conversion workers for run, which is num_threads or the number of cores.
+int worker_count( const conversion_settings& run );
+
+struct conversion_summary
+{
+	int converted = 0;
+	int failed = 0;
+	int elements = 0;
+	std::array< int, size_t( conversion_error::count ) > errors{}; // number of failed files per error code
+	int count( conversion_error e ) const { return errors[ size_t( e ) ]; }
+};
+
+/// Input for a conversion, contents are read from the input path if has_contents is false.
+struct conversion_item
+{
+	xo::path input;
+	std::string contents;
+	bool has_contents = false;
+};
+
+/// Hands an item to the conversion workers, waits while the workers are busy. Can be called from multiple threads.
+using conversion_sink = std::function< void( conversion_item&& ) >;
+
+/// Check if a filename is a class or struct XML file.
+bool is_input_file( const xo::path& input_path );
+
+/// Find all class and struct XML files in input_dir, sorted by filename so runs are reproducible.
+std::vector< xo::path > find_input_files( const xo::path& input_dir );
+
+/// Convert the items produced by produce( sink ), which runs on its own thread while the workers convert.
+/// Results are logged while converting and returned in the order in which they were produced.
+/// If that order is not reproducible, set sort_by_input to log and return results sorted by input path.
+std::vector< conversion_result > convert_stream( const std::function< void( const conversion_sink& ) >& produce,
+	const dokugen_settings& cfg, const conversion_settings& run, bool sort_by_input = false );
+
+/// Convert files in parallel; results are logged while converting and returned in the same order as files.
+std::vector< conversion_result > convert_files( const std::vector< xo::path >& files, const dokugen_settings& cfg, const conversion_settings& run );
+
+/// Convert the class and struct XML files in input_dir and all its subdirectories, while the directories are being read.
+/// Results are sorted by input path.
+std::vector< conversion_result > convert_tree( const xo::path& input_dir, const dokugen_settings& cfg, const conversion_settings& run,
+	const std::function< bool( const xo::path& ) >& select = nullptr );
+
+/// Convert the class and struct XML files in a tar stream, while the stream is being read.
+std::vector< conversion_result > convert_tar( std::istream& tar_stream, const dokugen_settings& cfg, const conversion_settings& run,
+	const std::function< bool( const std::string& ) >& select = nullptr );
+
+/// Worker threads that stay alive between conversions, so that their arenas and caches stay warm.
+/// Batches from multiple threads are converted at the same time by the same workers.
+class conversion_pool
+{
+public:
+	explicit conversion_pool( const conversion_settings& run );
+	conversion_pool( const conversion_pool& ) = delete;
+	conversion_pool& operator=( const conversion_pool& ) = delete;
+	~conversion_pool();
+
+	/// Convert files with cfg and wait until they are done, results are in the same order as files. Thread-safe.
+	std::vector< conversion_result > convert( const std::vector< xo::path >& files, const dokugen_settings& cfg );
+
+private:
+	struct batch
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t remaining = 0;
+	};
+	struct job
+	{
+		xo::path input;
+		const dokugen_settings* cfg = nullptr;
+		conversion_result* result = nullptr;
+		batch* owner = nullptr;
+	};
+	void run_worker( size_t worker_idx );
+
+	work_queue< job > queue_;
+	watchdog watchdog_;
+	std::vector< std::thread > threads_;
+};
+
+/// Read all compounds in files in parallel and build their inheritance graph, before any page is rendered.
+/// Only the graph entries are kept; models are loaded with cfg, so with a cache folder the conversion that follows
+/// reads them from the cache. Files are read under the file timeout of run; those that exceed it are left out.
+std::shared_ptr< const inheritance_graph > build_inheritance_graph( const std::vector< xo::path >& files,
+	const dokugen_settings& cfg, const conversion_settings& run );
+
+/// Aggregate counts over all results.
+conversion_summary summarize( const std::vector< conversion_result >& results );
@@ -0,0 +1,18 @@
+#include "conversion_error.h"
+
+const char* error_description( conversion_error e )
+{
+	switch ( e )
+	{
+	case conversion_error::none: return "no error";
+	case conversion_error::read_failed: return "could not be read";
+	case conversion_error::parse_failed: return "invalid XML";
+	case conversion_error::missing_doxygen: return "missing doxygen element";
+	case conversion_error::missing_compounddef: return "missing compounddef element";
+	case conversion_error::missing_compoundname: return "missing compoundname element";
+	case conversion_error::write_failed: return "could not be written";
+	case conversion_error::timed_out: return "timed out";
+	case conversion_error::unexpected: return "unexpected error";
+	default: return "unknown error";
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+/// Reasons why a file fails to convert.
+enum class conversion_error
+{
+	none,
+	read_failed,
+	parse_failed,
+	missing_doxygen,
+	missing_compounddef,
+	missing_compoundname,
+	write_failed,
+	timed_out,
+	unexpected,
+	count
+};
+
+/// Short description of an error code, used in summaries.
+const char* error_description( conversion_error e );
+
+/// Error code plus a message for the log.
+struct conversion_failure
+{
+	conversion_error code = conversion_error::none;
+	std::string message;
+};
+
+/// Result of a conversion step: either a value or a conversion_failure.
+/// Failures are returned instead of thrown, so broken inputs are cheap to skip.
+template< typename T >
+class expected
+{
+public:
+	expected( T value ) : value_( std::move( value ) ) {}
+	expected( conversion_failure failure ) : failure_( std::move( failure ) ) {}
+	expected( conversion_error code, std::string message ) : failure_{ code, std::move( message ) } {}
+
+	explicit operator bool() const { return failure_.code == conversion_error::none; }
+	T& value() { return value_; }
+	const T& value() const { return value_; }
+	T& operator*() { return value_; }
+	const T& operator*() const { return value_; }
+	T* operator->() { return &value_; }
+	const T* operator->() const { return &value_; }
+	const conversion_failure& failure() const { return failure_; }
+
+private:
+	T value_{};
+	conversion_failure failure_;
+};
@@ -0,0 +1,109 @@
+#include "dir_walker.h"
+
+#include "conversion.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "xo/system/assert.h"
+
+#ifndef _WIN32
+#	include <dirent.h>
+#	include <sys/stat.h>
+#endif
+
+using std::string;
+
+#ifdef _WIN32
+
+void walk_input_files( const xo::path& dir, int num_threads, const std::function< void( const xo::path& ) >& found )
+{
+	for ( auto& e : std::filesystem::recursive_directory_iterator( dir.str() ) )
+		if ( auto p = xo::path( e.path().string() ); is_input_file( p ) && e.is_regular_file() )
+			found( p );
+}
+
+#else
+
+// reads a directory with readdir, which fetches entries in bulk and reports their type without stat
+void read_directory( const string& dir, std::vector< string >& subdirs, const std::function< void( const xo::path& ) >& found )
+{
+	DIR* d = opendir( dir.c_str() );
+	xo_error_if( !d, "Could not open directory " + dir );
+
+	while ( dirent* e = readdir( d ) )
+	{
+		const char* name = e->d_name;
+		if ( name[ 0 ] == '.' && ( name[ 1 ] == 0 || ( name[ 1 ] == '.' && name[ 2 ] == 0 ) ) )
+			continue;
+
+		auto type = e->d_type;
+		if ( ( type == DT_REG || type == DT_LNK || type == DT_UNKNOWN ) && is_input_file( xo::path( name ) ) )
+			found( xo::path( dir ) / xo::path( name ) );
+		else if ( type == DT_DIR )
+			subdirs.push_back( dir + '/' + name );
+		else if ( type == DT_UNKNOWN )
+		{
+			// some file systems don't report types, stat only what could be a directory
+			struct stat st;
+			auto full = dir + '/' + name;
+			if ( lstat( full.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) )
+				subdirs.push_back( full );
+		}
+	}
+	closedir( d );
+}
+
+void walk_input_files( const xo::path& dir, int num_threads, const std::function< void( const xo::path& ) >& found )
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector< string > pending{ dir.str() };
+	int active = 0;
+	std::exception_ptr error;
+
+	// each thread takes a directory from the pending list and adds the subdirectories it finds
+	auto walker = [&]() {
+		std::vector< string > subdirs;
+		std::unique_lock< std::mutex > lock( mutex );
+		while ( true )
+		{
+			cv.wait( lock, [&]() { return !pending.empty() || active == 0 || error; } );
+			if ( error || pending.empty() )
+				break; // nothing pending and no walker that can add more
+
+			auto current = std::move( pending.back() );
+			pending.pop_back();
+			++active;
+			lock.unlock();
+
+			subdirs.clear();
+			std::exception_ptr read_error;
+			try { read_directory( current, subdirs, found ); }
+			catch ( ... ) { read_error = std::current_exception(); }
+
+			lock.lock();
+			--active;
+			if ( read_error && !error )
+				error = read_error;
+			pending.insert( pending.end(), subdirs.begin(), subdirs.end() );
+			cv.notify_all();
+		}
+		cv.notify_all();
+	};
+
+	std::vector< std::thread > threads;
+	for ( int i = 1; i < std::max( num_threads, 1 ); ++i )
+		threads.emplace_back( walker );
+	walker();
+	for ( auto& t : threads )
+		t.join();
+
+	if ( error )
+		std::rethrow_exception( error );
+}
+
+#endif
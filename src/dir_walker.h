@@ -0,0 +1,8 @@
+#pragma once
+
+#include "xo/filesystem/path.h"
+#include <functional>
+
+/// Walk dir and all its subdirectories using num_threads threads, calling found( file ) for each class or struct XML file.
+/// Files are matched by name only, without stat calls. found() is called from multiple threads while the walk is still going.
+void walk_input_files( const xo::path& dir, int num_threads, const std::function< void( const xo::path& ) >& found );
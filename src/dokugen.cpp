@@ -7,199 +7,593 @@
 #include "rapidxml_print.hpp"
 #include "xo/filesystem/filesystem.h"
 #include "xo/string/string_tools.h"
-#include "xo/utility/hash.h"
+#include "xml_text.h"
+#include "text_scan.h"
+#include "compound_model.h"
+#include "model_cache.h"
+#include "watchdog.h"
+#include "arena.h"
+#include "inheritance_graph.h"
+#include "helper_pool.h"
+#include <algorithm>
+#include <csetjmp>
+#include <memory_resource>
+#include <unordered_set>
 
 using namespace xo;
 using namespace rapidxml;
 
-using std::endl, std::ofstream, std::string;
-
-#define FOR_EACH_XML_NODE( _parent_, _child_, _name_ ) \
-for ( auto* _child_ = _parent_->first_node( _name_ ); _child_; _child_ = _child_->next_sibling( _name_ ) )
-
+using std::string, std::string_view;
 
 string fix_string( string str, const dokugen_settings& cfg ) {
-	for ( auto& s : cfg.remove_strings )
-		xo::replace_str( str, s, "" );
+	cfg.remove_strings->apply( str );
 	if ( cfg.remove_trailing_underscores )
 		str = xo::trim_right_str( str, "_" );
 	return str;
 }
 
-string extract_ref( xml_node<>* node, const dokugen_settings& cfg )
+template< typename E > const markup& get_markup( text_markup m )
+{
+	switch ( m )
+	{
+	case text_markup::emphasis: return E::emphasis;
+	case text_markup::bold: return E::bold;
+	case text_markup::subscript: return E::subscript;
+	case text_markup::verbatim: return E::verbatim;
+	case text_markup::list: return E::list;
+	default: return E::list_item;
+	}
+}
+
+// rendered fragments that repeat across compounds are shared through cfg.interner
+enum class fragment : char { link, text, attribute_name, function_name };
+
+template< typename E > char fragment_tag( fragment f ) {
+	return char( 1 + int( E::format ) * 4 + int( f ) );
+}
+
+string_view trim_view( string_view s )
 {
-	if ( auto* id = node->first_attribute( "refid" ) )
-		return string( "[[" ) + fix_string( id->value(), cfg ) + "|" + node->value() + "]]";
-	else return "";
+	const char* space = " \t\r\n\f\v";
+	auto begin = s.find_first_not_of( space );
+	if ( begin == string_view::npos )
+		return string_view();
+	return s.substr( begin, s.find_last_not_of( space ) - begin + 1 );
 }
 
-string extract_text( xml_node<>* node, const dokugen_settings& cfg )
+template< typename E > void render_link( string& out, string_view link, const dokugen_settings& cfg )
 {
-	string result;
+	auto end = link.data() + link.size();
+	auto link_text = std::find( link.data(), end, char( text_code::link_text ) );
+	auto link_close = std::find( link_text, end, char( text_code::link_close ) );
+	string target( link.data() + 1, link_text );
+	string link_str;
+	if ( link_text != end )
+		E::text( link_str, string_view( link_text + 1, link_close - link_text - 1 ), text_context::link_text );
+	E::link( out, fix_string( target, cfg ), link_str );
+}
 
-	for ( xml_node<>* child = node->first_node(); child; child = child->next_sibling() )
+template< typename E > void append_text( string& out, string_view s, text_context c ) {
+	E::text( out, s, c );
+}
+
+// text that needs no escaping is referenced instead of copied
+template< typename E > void append_text( page_slices& out, string_view s, text_context c )
+{
+	if ( E::is_plain( s, c ) )
+		out.append( s );
+	else
 	{
-		if ( child->type() == node_element )
-		{
-			auto name = string( child->name() );
-			switch ( xo::hash( name ) )
-			{
-			case "para"_hash: result += extract_text( child, cfg ); break;
-			case "ref"_hash: result += extract_ref( child, cfg ); break;
-			case "emphasis"_hash: result += "//" + extract_text( child, cfg ) + "//"; break;
-			case "bold"_hash: result += "**" + extract_text( child, cfg ) + "**"; break;
-			case "subscript"_hash: result += "<sub>" + extract_text( child, cfg ) + "</sub>"; break;
-			case "verbatim"_hash: result += "<code>" + extract_text( child, cfg ) + "</code>"; break;
-			case "itemizedlist"_hash: result += extract_text( child, cfg ) + "\n"; break;
-			case "listitem"_hash: result += "\n  * " + extract_text( child, cfg ); break;
-			}
-		}
-		else result += child->value();
+		auto& text = out.new_text();
+		E::text( text, s, c );
+		out.append( text );
 	}
-	return result;
 }
 
-int write_inherited_from( xml_node<>* root, const dokugen_settings& cfg, ofstream& str )
+// translate format-neutral model text into emitter markup, plain text is escaped for context c
+template< typename E, typename S > void render_text( S& out, string_view text, const dokugen_settings& cfg, text_context c )
 {
-	auto base_count = 0;
-	FOR_EACH_XML_NODE( root, node, "basecompoundref" )
+	auto verbatim_context = c == text_context::table_cell ? text_context::verbatim_cell : text_context::verbatim;
+	bool verbatim = false;
+	auto p = text.data(), end = text.data() + text.size();
+	while ( p != end )
 	{
-		if ( auto s = extract_ref( node, cfg ); !s.empty() )
+		auto code = scan_for< char( text_code::markup_open ), char( text_code::markup_close ), char( text_code::link_open ) >( p, end );
+		if ( code != p )
+			append_text< E >( out, string_view( p, code - p ), verbatim ? verbatim_context : c );
+		if ( code == end || code + 1 == end )
+			break;
+
+		switch ( text_code( *code ) )
+		{
+		case text_code::markup_open:
+			out += get_markup< E >( text_markup( code[ 1 ] ) ).open;
+			verbatim |= text_markup( code[ 1 ] ) == text_markup::verbatim;
+			p = code + 2;
+			break;
+		case text_code::markup_close:
+			out += get_markup< E >( text_markup( code[ 1 ] ) ).close;
+			verbatim &= text_markup( code[ 1 ] ) != text_markup::verbatim;
+			p = code + 2;
+			break;
+		default:
 		{
-			if ( base_count++ == 0 )
-				str << endl << "**Inherits from** " << s;
-			else str << ", " << s;
+			auto link_close = std::find( code, end, char( text_code::link_close ) );
+			p = link_close == end ? end : link_close + 1;
+			auto link = string_view( code, p - code );
+			out += cfg.interner->find_or_add( fragment_tag< E >( fragment::link ), link,
+				[&]( string& s ) { render_link< E >( s, link, cfg ); } );
+			break;
+		}
 		}
 	}
-	if ( base_count > 0 )
-		str << "." << endl;
-	return base_count;
 }
 
-int write_inherited_by( xml_node<>* root, const dokugen_settings& cfg, ofstream& str )
+// rendered text as a single view that is valid until the page is written, only copied if it consists of multiple slices
+template< typename E > string_view render_text( string_view text, const dokugen_settings& cfg, text_context c, page_slices& page )
 {
-	auto derived_count = 0;
-	FOR_EACH_XML_NODE( root, node, "derivedcompoundref" )
-	{
-		if ( auto s = extract_ref( node, cfg ); !s.empty() )
+	page_slices result( page );
+	render_text< E >( result, text, cfg, c );
+	return result.join();
+}
+
+template< typename E > string_view escaped_text( string_view s, page_slices& page )
+{
+	page_slices result( page );
+	append_text< E >( result, s, text_context::inline_text );
+	return result.join();
+}
+
+// fragments are the names, types and arguments in table rows
+template< typename E > string_view render_fragment( fragment f, string_view text, const dokugen_settings& cfg )
+{
+	return cfg.interner->find_or_add( fragment_tag< E >( f ), text, [&]( string& s ) {
+		switch ( f )
 		{
-			if ( derived_count++ == 0 )
-				str << endl << "**Inherited by** " << s;
-			else str << ", " << s;
+		case fragment::attribute_name: E::text( s, fix_string( string( text ), cfg ), text_context::table_cell ); break;
+		case fragment::function_name: E::text( s, text, text_context::table_cell ); break;
+		default: render_text< E >( s, text, cfg, text_context::table_cell );
 		}
+	} );
+}
+
+template< typename E > string_view render_links( const std::vector< string_view >& refs, const dokugen_settings& cfg, page_slices& page )
+{
+	page_slices links( page );
+	for ( auto& r : refs )
+	{
+		if ( !links.empty() )
+			links += ", ";
+		render_text< E >( links, r, cfg, text_context::inline_text );
 	}
-	if ( derived_count > 0 )
-		str << "." << endl;
-	return derived_count;
+	return links.join();
 }
 
-int write_attributes( xml_node<>* root, string &parent_brief, const dokugen_settings& cfg, ofstream &str )
+std::vector< string_view > model_links( const compound_model& m, const std::vector< pool_string >& refs )
 {
-	auto attrib_count = 0;
-	FOR_EACH_XML_NODE( root, section, "sectiondef" )
+	std::vector< string_view > links;
+	for ( auto& r : refs )
+		links.push_back( m.str( r ) );
+	return links;
+}
+
+std::vector< string_view > graph_links( const inheritance_graph& g, const std::vector< inheritance_graph::node >& nodes )
+{
+	std::vector< string_view > links;
+	for ( auto n : nodes )
+		links.push_back( g.link( n ) );
+	return links;
+}
+
+template< typename E > int write_relations( const std::vector< string_view >& links, page_layout::section s, const page_layout& layout, const dokugen_settings& cfg, page_slices& out )
+{
+	if ( !links.empty() )
 	{
-		string kind = section->first_attribute( "kind" )->value();
-		if ( kind == "public-attrib" )
-		{
-			FOR_EACH_XML_NODE( section, member, "memberdef" )
-			{
-				auto brief = xo::trim_str( extract_text( member->first_node( "briefdescription" ), cfg ) );
-				if ( !brief.empty() )
-				{
-					if ( attrib_count++ == 0 )
-					{
-						str << endl << "==== Public Attributes ====" << endl;
-						str << "^ Parameter ^ Type ^ Description ^" << endl;
-					}
-
-					auto name = fix_string( member->first_node( "name" )->value(), cfg );
-					auto type = extract_text( member->first_node( "type" ), cfg );
-					str << "^ " << name;
-					str << " | " << type;
-					str << " | " << brief;
-					str << " |" << endl;
-				}
-			}
-		}
+		layout_values v;
+		v[ size_t( layout_field::links ) ] = render_links< E >( links, cfg, out );
+		layout.render( s, out, v );
 	}
-	return attrib_count;
+	return int( links.size() );
+}
+
+template< typename E > int write_inherited_from( const compound_model& m, const page_layout& layout, const dokugen_settings& cfg, page_slices& out ) {
+	return write_relations< E >( model_links( m, m.bases ), page_layout::inherits_from, layout, cfg, out );
+}
+
+template< typename E > int write_inherited_by( const compound_model& m, const page_layout& layout, const dokugen_settings& cfg, page_slices& out ) {
+	return write_relations< E >( model_links( m, m.derived ), page_layout::inherited_by, layout, cfg, out );
 }
 
-int write_members( xml_node<>* root, string &parent_brief, const dokugen_settings& cfg, ofstream &str )
+// all bases or derived compounds from the inheritance graph, only if there are more than the direct ones
+template< typename E > void write_indirect_relations( const std::vector< string_view >& links, size_t direct, page_layout::section s,
+	const page_layout& layout, const dokugen_settings& cfg, page_slices& out )
 {
-	auto count = 0;
-	FOR_EACH_XML_NODE( root, section, "sectiondef" )
+	if ( links.size() > direct )
+		write_relations< E >( links, s, layout, cfg, out );
+}
+
+// documented members of the public bases, except those that are hidden by a member of the compound or of a nearer base,
+// including members that have no row, such as undocumented and non-public members
+template< typename E > void write_inherited_members( const compound_model& m, const inheritance_graph& g, const std::vector< inheritance_graph::node >& ancestors,
+	const page_layout& layout, const dokugen_settings& cfg, page_slices& out )
+{
+	std::unordered_set< string_view > hidden;
+	for ( auto* names : { &m.functions.name, &m.attributes.name, &m.other_members } )
+		for ( auto& n : *names )
+			hidden.insert( m.str( n ) );
+
+	for ( auto a : ancestors )
 	{
-		string kind = section->first_attribute( "kind" )->value();
-		if ( kind == "public-func" || kind == "public-static-func" )
+		// attribute names are shown as in the attribute table
+		page_slices members( out );
+		auto add_member = [&]( string_view name ) {
+			if ( !members.empty() )
+				members += ", ";
+			append_text< E >( members, name, text_context::inline_text );
+		};
+		for ( auto& n : g.functions( a ) )
+			if ( auto name = g.str( n ); hidden.insert( name ).second )
+				add_member( name );
+		for ( auto& n : g.attributes( a ) )
+			if ( auto name = g.str( n ); hidden.insert( name ).second )
+				add_member( members.new_text() = fix_string( string( name ), cfg ) );
+		for ( auto& n : g.other_members( a ) )
+			hidden.insert( g.str( n ) );
+		if ( members.empty() )
+			continue;
+
+		layout_values v;
+		v[ size_t( layout_field::links ) ] = render_text< E >( g.link( a ), cfg, text_context::inline_text, out );
+		v[ size_t( layout_field::members ) ] = members.join();
+		layout.render( page_layout::inherited_members, out, v );
+	}
+}
+
+// compounds with at least this many members render their rows in parallel, in chunks of at least parallel_chunk_rows
+const size_t parallel_row_threshold = 1024;
+const size_t parallel_chunk_rows = 256;
+
+/// Render the table rows for n members between header and footer, render_row( i, out ) returns false if member i has no row.
+/// Large tables are split into chunks that are rendered by the worker and idle helpers, and appended in order.
+template< typename F > int write_rows( size_t n, page_layout::section header, page_layout::section footer,
+	const page_layout& layout, const dokugen_settings& cfg, page_slices& out, F render_row )
+{
+	// the header is removed again if there are no rows
+	auto begin = out.mark();
+	layout.render( header, out );
+
+	// more chunks than threads, so threads that join late or finish early still share the work
+	int count = 0;
+	auto num_threads = cfg.helpers ? cfg.helpers->size() + 1 : 1;
+	auto num_chunks = std::min< size_t >( n / parallel_chunk_rows, 4 * num_threads );
+	if ( n < parallel_row_threshold || num_threads < 2 || num_chunks < 2 )
+	{
+		for ( size_t i = 0; i < n; ++i )
 		{
-			FOR_EACH_XML_NODE( section, member, "memberdef" )
+			check_cancelled();
+			count += render_row( i, out );
+		}
+	}
+	else
+	{
+		// each chunk has its own memory, monotonic_buffer_resource is not thread-safe;
+		// chunks are kept alive by the page, since it refers to their text
+		struct chunk
+		{
+			std::pmr::monotonic_buffer_resource mem;
+			page_slices text{ &mem };
+			int count = 0;
+			std::exception_ptr error;
+		};
+		std::vector< std::shared_ptr< chunk > > chunks;
+		for ( size_t c = 0; c < num_chunks; ++c )
+			chunks.emplace_back( std::make_shared< chunk >() );
+
+		// helpers share the time budget of the worker
+		auto* cancel = cancel_flag();
+		auto render_chunk = [&]( size_t c ) {
+			auto* previous_cancel = cancel_flag();
+			set_cancel_flag( cancel );
+			auto& ch = *chunks[ c ];
+			try
 			{
-				auto brief = xo::trim_str( extract_text( member->first_node( "briefdescription" ), cfg ) );
-				if ( !brief.empty() )
+				for ( size_t i = c * n / num_chunks; i < ( c + 1 ) * n / num_chunks; ++i )
 				{
-					if ( count++ == 0 )
-					{
-						str << endl << "==== Public Functions ====" << endl;
-						str << "^ Function ^ Description ^" << endl;
-					}
-
-					str << "| " << extract_text( member->first_node( "type" ), cfg );
-					str << " **" << member->first_node( "name" )->value() << "**";
-					str << extract_text( member->first_node( "argsstring" ), cfg );
-					str << " | " << brief;
-					str << " |" << endl;
+					check_cancelled();
+					ch.count += render_row( i, ch.text );
 				}
 			}
+			catch ( ... )
+			{
+				ch.error = std::current_exception();
+			}
+			set_cancel_flag( previous_cancel );
+		};
+		cfg.helpers->run( num_chunks, render_chunk );
+
+		for ( auto& ch : chunks )
+			if ( ch->error )
+				std::rethrow_exception( ch->error );
+		for ( auto& ch : chunks )
+		{
+			out.append( ch->text, ch );
+			count += ch->count;
 		}
 	}
+
+	if ( count > 0 )
+		layout.render( footer, out );
+	else out.rewind( begin );
 	return count;
 }
 
-int write_doku( const xo::path& input, const dokugen_settings& cfg )
+template< typename E > int write_attributes( const compound_model& m, const page_layout& layout, const dokugen_settings& cfg, page_slices& out )
 {
-	path output = cfg.output_dir / fix_string( input.filename().replace_extension( "txt" ).str(), cfg );
+	auto& attributes = m.attributes;
+	return write_rows( attributes.size(), page_layout::attribute_header, page_layout::attribute_footer, layout, cfg, out,
+		[&]( size_t i, page_slices& rows ) {
+			auto brief = trim_view( render_text< E >( m.str( attributes.brief[ i ] ), cfg, text_context::table_cell, rows ) );
+			if ( brief.empty() )
+				return false;
 
-	rapidxml::xml_document<> doc;
-	string file_contents = load_string( input );
-	doc.parse< 0 >( &file_contents[ 0 ] );
+			auto name = render_fragment< E >( fragment::attribute_name, m.str( attributes.name[ i ] ), cfg );
+			auto type = render_fragment< E >( fragment::text, m.str( attributes.type[ i ] ), cfg );
+			layout_values v;
+			v[ size_t( layout_field::name ) ] = name;
+			v[ size_t( layout_field::type ) ] = type;
+			v[ size_t( layout_field::brief ) ] = brief;
+			layout.render( page_layout::attribute_row, rows, v );
+			return true;
+		} );
+}
 
-	xml_node<>* root = doc.first_node( "doxygen" );
-	xo_error_if( !root, "Could not find doxygen" );
-	root = root->first_node( "compounddef" );
-	xo_error_if( !root, "Could not find compounddef" );
+template< typename E > int write_members( const compound_model& m, const page_layout& layout, const dokugen_settings& cfg, page_slices& out )
+{
+	auto& functions = m.functions;
+	return write_rows( functions.size(), page_layout::function_header, page_layout::function_footer, layout, cfg, out,
+		[&]( size_t i, page_slices& rows ) {
+			auto brief = trim_view( render_text< E >( m.str( functions.brief[ i ] ), cfg, text_context::table_cell, rows ) );
+			if ( brief.empty() )
+				return false;
+
+			auto type = render_fragment< E >( fragment::text, m.str( functions.type[ i ] ), cfg );
+			auto name = render_fragment< E >( fragment::function_name, m.str( functions.name[ i ] ), cfg );
+			auto args = render_fragment< E >( fragment::text, m.str( functions.args[ i ] ), cfg );
+			layout_values v;
+			v[ size_t( layout_field::type ) ] = type;
+			v[ size_t( layout_field::name ) ] = name;
+			v[ size_t( layout_field::args ) ] = args;
+			v[ size_t( layout_field::brief ) ] = brief;
+			layout.render( page_layout::function_row, rows, v );
+			return true;
+		} );
+}
+
+// room for text generated while rendering a page, such as escaped names; more is taken from the heap
+const size_t page_text_size = 65536;
+
+// relations of a compound in cfg.graph, which are the same for all output formats
+struct graph_relations
+{
+	std::vector< inheritance_graph::node > ancestors;
+	std::vector< inheritance_graph::node > public_ancestors; // bases whose members are inherited as public members
+	std::vector< string_view > ancestor_links;
+	std::vector< string_view > descendant_links;
+};
 
-	auto name = xo::tidy_type_name( root->first_node( "compoundname" )->value() );
-	auto brief = extract_text( root->first_node( "briefdescription" ), cfg );
-	auto detailed = extract_text( root->first_node( "detaileddescription" ), cfg );
+template< typename E > expected< int > write_page( const xo::path& input, const compound_model& m, const graph_relations& rel,
+	const page_layout& layout, const dokugen_settings& cfg )
+{
+	// the page is a list of slices, most of which refer to the model, the layout or interned fragments;
+	// the slice list and generated text are allocated from a thread-local buffer and released in one go when the page is done
+	// the slice list is reserved for the largest page of the thread so far, so it only regrows for a new largest page
+	thread_local std::vector< char > page_buffer;
+	thread_local size_t max_slices = 1024;
+	page_buffer.resize( std::max( page_buffer.size(), max_slices * sizeof( string_view ) + page_text_size ) );
+	std::pmr::monotonic_buffer_resource mem( page_buffer.data(), page_buffer.size() );
+	page_slices out( &mem );
+	out.reserve( max_slices );
 
+	auto brief = render_text< E >( m.str( m.brief ), cfg, text_context::inline_text, out );
 	if ( brief.empty() )
 		return 0;
 
-	ofstream str( output.str() );
-	xo_error_if( !str.good(), "Could not open " + output.str() );
+	auto name = escaped_text< E >( m.str( m.name ), out );
+	auto detailed = render_text< E >( m.str( m.detailed ), cfg, text_context::inline_text, out );
 
 	// title + description
-	str << "====== " << name << " ======" << endl;
-	str << brief << endl;
+	layout_values v;
+	v[ size_t( layout_field::name ) ] = name;
+	v[ size_t( layout_field::brief ) ] = brief;
+	v[ size_t( layout_field::detailed ) ] = detailed;
+	layout.render( page_layout::title, out, v );
 	if ( !detailed.empty() )
-		str << endl << detailed << endl;
+		layout.render( page_layout::detailed, out, v );
 
 	int elem = 0;
 
 	// inherited from
-	elem += write_inherited_from( root, cfg, str );
+	elem += write_inherited_from< E >( m, layout, cfg, out );
 
 	// inherited by
-	elem += write_inherited_by( root, cfg, str );
+	elem += write_inherited_by< E >( m, layout, cfg, out );
+
+	// all bases and derived compounds
+	write_indirect_relations< E >( rel.ancestor_links, m.bases.size(), page_layout::ancestors, layout, cfg, out );
+	write_indirect_relations< E >( rel.descendant_links, m.derived.size(), page_layout::descendants, layout, cfg, out );
 
 	// public attributes
-	elem += write_attributes( root, brief, cfg, str );
+	elem += write_attributes< E >( m, layout, cfg, out );
 
 	// public members
-	elem += write_members( root, brief, cfg, str );
+	elem += write_members< E >( m, layout, cfg, out );
+
+	// inherited members
+	if ( cfg.graph )
+		write_inherited_members< E >( m, *cfg.graph, rel.public_ancestors, layout, cfg, out );
 
-	str << endl << "<sub>Converted from doxygen using [[https://github.com/tgeijten/dokugen|dokugen]]</sub>" << endl;
+	layout.render( page_layout::footer, out );
+	max_slices = std::max( max_slices, out.size() );
+
+	auto filename = fix_string( path( input.filename() ).replace_extension( E::extension ).str(), cfg );
+	path output = cfg.output_dir / path( filename );
+	if ( !cfg.sink->write( output, out ) )
+		return { conversion_error::write_failed, "Could not write " + output.str() };
+
+	// report the compounds this page links to, so the sink can check they have a page
+	auto page = string_view( filename ).substr( 0, filename.rfind( '.' ) );
+	for ( auto& links : { model_links( m, m.bases ), model_links( m, m.derived ), rel.ancestor_links, rel.descendant_links } )
+		for ( auto link : links )
+		{
+			auto target = link.substr( 1, link.find( char( text_code::link_text ) ) - 1 );
+			cfg.sink->add_reference( page, fix_string( string( target ), cfg ) );
+		}
 
 	return elem;
 }
+
+// rapidxml is built with RAPIDXML_NO_EXCEPTIONS, parse errors jump back to parse_xml() instead of unwinding
+thread_local std::jmp_buf* parse_error_jump = nullptr;
+thread_local const char* parse_error_what = nullptr;
+
+namespace rapidxml
+{
+	void parse_error_handler( const char* what, void* /*where*/ )
+	{
+		parse_error_what = what;
+		std::longjmp( *parse_error_jump, 1 );
+	}
+}
+
+/// Parse text into doc, returns the parse error or nullptr on success.
+/// No objects with destructors may live in this frame, since longjmp skips them.
+const char* parse_xml( xml_document<>& doc, char* text )
+{
+	std::jmp_buf jump;
+	parse_error_jump = &jump;
+	if ( setjmp( jump ) != 0 )
+	{
+		parse_error_jump = nullptr;
+		return parse_error_what;
+	}
+	try
+	{
+		doc.parse< parse_no_entity_translation >( text );
+	}
+	catch ( ... ) // conversion_timeout from the allocator
+	{
+		parse_error_jump = nullptr;
+		throw;
+	}
+	parse_error_jump = nullptr;
+	return nullptr;
+}
+
+expected< compound_model > read_compound( string& file_contents )
+{
+	// the DOM lives in the thread's arena, which is reset in one go once the model is extracted
+	arena_scope scope;
+	rapidxml::xml_document<> doc;
+	doc.set_allocator( arena_allocate, arena_free );
+	if ( auto* error = parse_xml( doc, &file_contents[ 0 ] ) )
+		return { conversion_error::parse_failed, error };
+
+	xml_node<>* root = doc.first_node( "doxygen" );
+	if ( !root )
+		return { conversion_error::missing_doxygen, "Could not find doxygen" };
+	root = root->first_node( "compounddef" );
+	if ( !root )
+		return { conversion_error::missing_compounddef, "Could not find compounddef" };
+	if ( !root->first_node( "compoundname" ) )
+		return { conversion_error::missing_compoundname, "Could not find compoundname" };
+
+	return extract_compound( root );
+}
+
+expected< compound_model > load_compound( string& file_contents, const dokugen_settings& cfg )
+{
+	// the model doesn't depend on settings, so a cached model can be used to render with any settings
+	if ( !cfg.cache_dir.empty() )
+	{
+		compound_model m;
+		auto key = model_cache_key( file_contents );
+		if ( !load_cached_model( cfg.cache_dir, key, m ) )
+		{
+			auto r = read_compound( file_contents );
+			if ( !r )
+				return r;
+			m = std::move( *r );
+			save_cached_model( cfg.cache_dir, key, m );
+		}
+		return m;
+	}
+	else return read_compound( file_contents );
+}
+
+expected< int > write_pages( const xo::path& input, const compound_model& m, const dokugen_settings& cfg )
+{
+	// compounds are in the graph by refid, which is the name of their file
+	graph_relations rel;
+	if ( cfg.graph )
+	{
+		auto refid = input.filename().str();
+		auto node = cfg.graph->find( refid.substr( 0, refid.rfind( '.' ) ) );
+		if ( node != inheritance_graph::no_node )
+		{
+			rel.ancestors = cfg.graph->ancestors( node );
+			rel.public_ancestors = cfg.graph->public_ancestors( node );
+			rel.ancestor_links = graph_links( *cfg.graph, rel.ancestors );
+			rel.descendant_links = graph_links( *cfg.graph, cfg.graph->descendants( node ) );
+		}
+	}
+
+	// each output format renders its page from the same model
+	int elem = 0;
+	for ( auto& o : cfg.outputs )
+	{
+		expected< int > n = 0;
+		switch ( o.format )
+		{
+		case output_format::dokuwiki: n = write_page< dokuwiki_emitter >( input, m, rel, o.layout, cfg ); break;
+		case output_format::markdown: n = write_page< markdown_emitter >( input, m, rel, o.layout, cfg ); break;
+		case output_format::html: n = write_page< html_emitter >( input, m, rel, o.layout, cfg ); break;
+		}
+		if ( !n )
+			return n;
+		elem = std::max( elem, *n );
+	}
+	return elem;
+}
+
+expected< string > read_input_file( const xo::path& input )
+{
+	std::ifstream str( input.str(), std::ios::binary );
+	if ( !str.is_open() )
+		return { conversion_error::read_failed, "Could not open " + input.str() };
+	string file_contents( std::istreambuf_iterator< char >( str ), {} );
+	if ( str.bad() )
+		return { conversion_error::read_failed, "Could not read " + input.str() };
+	return file_contents;
+}
+
+expected< int > write_doku( const xo::path& input, const dokugen_settings& cfg )
+{
+	auto file_contents = read_input_file( input );
+	if ( !file_contents )
+		return file_contents.failure();
+	return write_doku( input, *file_contents, cfg );
+}
+
+expected< int > write_doku( const xo::path& input, string& file_contents, const dokugen_settings& cfg )
+{
+	// about half of the compounds have no brief and produce no page, skip those without parsing
+	if ( has_empty_brief( file_contents ) )
+		return 0;
+
+	check_cancelled();
+	auto m = load_compound( file_contents, cfg );
+	if ( !m )
+		return m.failure();
+	check_cancelled();
+	return write_pages( input, *m, cfg );
+}
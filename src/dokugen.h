@@ -2,12 +2,51 @@
 
 #include "xo/container/prop_node.h"
 #include "xo/filesystem/path.h"
+#include "page_layout.h"
+#include "emitters.h"
+#include "compound_model.h"
+#include "string_interner.h"
+#include "conversion_error.h"
+#include "page_sink.h"
+#include "remove_matcher.h"
+#include <memory>
+
+class inheritance_graph;
+class helper_pool;
+
+struct output_settings
+{
+	output_format format;
+	page_layout layout;
+};
 
 struct dokugen_settings
 {
 	xo::path output_dir;
-	std::vector< std::string > remove_strings;
+	std::shared_ptr< const remove_matcher > remove_strings = std::make_shared< remove_matcher >();
 	bool remove_trailing_underscores = true;
+	std::vector< output_settings > outputs;
+	xo::path cache_dir;
+	std::shared_ptr< string_interner > interner = std::make_shared< string_interner >();
+	std::shared_ptr< page_sink > sink = std::make_shared< file_sink >();
+	std::shared_ptr< const inheritance_graph > graph; // if set, pages also list indirect relations and inherited members
+	std::shared_ptr< helper_pool > helpers; // if set, large member tables are rendered with help from idle helpers
 };
 
-int write_doku( const xo::path& input, const dokugen_settings& cfg );
+/// Apply remove strings and trailing underscore removal to a name.
+std::string fix_string( std::string str, const dokugen_settings& cfg );
+
+/// Read the contents of an input file.
+expected< std::string > read_input_file( const xo::path& input );
+
+/// Convert a doxygen XML file, returns the number of elements written or the reason the conversion failed.
+expected< int > write_doku( const xo::path& input, const dokugen_settings& cfg );
+
+/// Convert a doxygen XML file that is already in memory; file_contents is modified during parsing.
+expected< int > write_doku( const xo::path& input, std::string& file_contents, const dokugen_settings& cfg );
+
+/// Get the compound model from file_contents or the model cache; file_contents is modified during parsing.
+expected< compound_model > load_compound( std::string& file_contents, const dokugen_settings& cfg );
+
+/// Render and write the pages of a compound model for all output formats.
+expected< int > write_pages( const xo::path& input, const compound_model& m, const dokugen_settings& cfg );
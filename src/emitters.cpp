@@ -0,0 +1,284 @@
+#include "emitters.h"
+
+#include "xo/system/assert.h"
+#include "text_scan.h"
+#include <memory_resource>
+
+const char* dokuwiki_emitter::default_layout =
+R"([title]
+====== {name} ======
+{brief}
+[detailed]
+
+{detailed}
+[inherits_from]
+
+**Inherits from** {links}.
+[inherited_by]
+
+**Inherited by** {links}.
+[ancestors]
+
+**All base classes** {links}.
+[descendants]
+
+**All derived classes** {links}.
+[attribute_header]
+
+==== Public Attributes ====
+^ Parameter ^ Type ^ Description ^
+[attribute_row]
+^ {name} | {type} | {brief} |
+[function_header]
+
+==== Public Functions ====
+^ Function ^ Description ^
+[function_row]
+| {type} **{name}**{args} | {brief} |
+[inherited_members]
+
+**Inherited from** {links}: {members}.
+[footer]
+
+<sub>Converted from doxygen using [[https://github.com/tgeijten/dokugen|dokugen]]</sub>
+)";
+
+const char* markdown_emitter::default_layout =
+R"([title]
+# {name}
+{brief}
+[detailed]
+
+{detailed}
+[inherits_from]
+
+**Inherits from** {links}.
+[inherited_by]
+
+**Inherited by** {links}.
+[ancestors]
+
+**All base classes** {links}.
+[descendants]
+
+**All derived classes** {links}.
+[attribute_header]
+
+## Public Attributes
+| Parameter | Type | Description |
+| --- | --- | --- |
+[attribute_row]
+| {name} | {type} | {brief} |
+[function_header]
+
+## Public Functions
+| Function | Description |
+| --- | --- |
+[function_row]
+| {type} **{name}**{args} | {brief} |
+[inherited_members]
+
+**Inherited from** {links}: {members}.
+[footer]
+
+<sub>Converted from doxygen using [dokugen](https://github.com/tgeijten/dokugen)</sub>
+)";
+
+const char* html_emitter::default_layout =
+R"([title]
+<h1>{name}</h1>
+<div>{brief}</div>
+[detailed]
+<div>{detailed}</div>
+[inherits_from]
+<p><b>Inherits from</b> {links}.</p>
+[inherited_by]
+<p><b>Inherited by</b> {links}.</p>
+[ancestors]
+<p><b>All base classes</b> {links}.</p>
+[descendants]
+<p><b>All derived classes</b> {links}.</p>
+[attribute_header]
+<h2>Public Attributes</h2>
+<table>
+<tr><th>Parameter</th><th>Type</th><th>Description</th></tr>
+[attribute_row]
+<tr><td>{name}</td><td>{type}</td><td>{brief}</td></tr>
+[attribute_footer]
+</table>
+[function_header]
+<h2>Public Functions</h2>
+<table>
+<tr><th>Function</th><th>Description</th></tr>
+[function_row]
+<tr><td>{type} <b>{name}</b>{args}</td><td>{brief}</td></tr>
+[function_footer]
+</table>
+[inherited_members]
+<p><b>Inherited from</b> {links}: {members}.</p>
+[footer]
+<p><sub>Converted from doxygen using <a href="https://github.com/tgeijten/dokugen">dokugen</a></sub></p>
+)";
+
+// DokuWiki formatting, links and media are written as pairs of these characters, table cells are separated by | and ^
+inline bool is_dokuwiki_markup( char c ) { return is_one_of< '|', '^', '/', '*', '_', '\'', '[', '{' >( c ); }
+
+/// Find the next markup in [p, end) that DokuWiki would interpret in context c, or end if there is none.
+/// Consecutive markup characters are escaped together, len is set to their number.
+const char* find_dokuwiki_markup( const char* begin, const char* p, const char* end, text_context c, size_t& len )
+{
+	// link titles are not parsed for markup, and code blocks are shown as is
+	if ( c == text_context::link_text || c == text_context::verbatim || c == text_context::verbatim_cell )
+		return end;
+
+	for ( ; ( p = scan_for< '|', '^', '/', '*', '_', '\'', '[', '{', '%' >( p, end ) ) != end; ++p )
+	{
+		char next = p + 1 != end ? p[ 1 ] : 0;
+		bool markup = false;
+		switch ( *p )
+		{
+		case '|': case '^': markup = c == text_context::table_cell; break;
+		case '%': if ( next == '%' ) { len = 2; return p; } break;
+		case '/': markup = next == '/' && !( p != begin && p[ -1 ] == ':' ); break; // leave urls to be linked
+		default: markup = next == *p; break;
+		}
+		if ( markup )
+		{
+			auto q = p;
+			while ( q != end && is_dokuwiki_markup( *q ) )
+				++q;
+			len = q - p;
+			return p;
+		}
+	}
+	return end;
+}
+
+bool dokuwiki_emitter::is_plain( std::string_view s, text_context c )
+{
+	size_t len;
+	return find_dokuwiki_markup( s.data(), s.data(), s.data() + s.size(), c, len ) == s.data() + s.size();
+}
+
+template< typename S > void dokuwiki_emitter::text( S& out, std::string_view s, text_context c )
+{
+	auto begin = s.data(), p = begin, end = begin + s.size();
+	while ( p != end )
+	{
+		size_t len = 0;
+		auto markup = find_dokuwiki_markup( begin, p, end, c, len );
+		out.append( p, markup );
+		if ( markup == end )
+			break;
+		if ( *markup == '%' )
+			out += "<nowiki>%%</nowiki>";
+		else { out += "%%"; out.append( markup, markup + len ); out += "%%"; }
+		p = markup + len;
+	}
+}
+
+template void dokuwiki_emitter::text( std::string& out, std::string_view s, text_context c );
+template void dokuwiki_emitter::text( std::pmr::string& out, std::string_view s, text_context c );
+
+// underscores inside a word never start emphasis, so names like m_value are left alone
+inline bool is_word_char( char c ) { return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ); }
+
+/// Find the next character in [p, end) that Markdown would interpret in context c, or end if there is none.
+/// Code spans are shown as is, only | must still be escaped to keep a table cell intact.
+const char* find_markdown_markup( const char* begin, const char* p, const char* end, text_context c )
+{
+	if ( c == text_context::verbatim )
+		return end;
+	if ( c == text_context::verbatim_cell )
+		return scan_for< '|' >( p, end );
+
+	for ( ; ( p = scan_for< '|', '*', '_', '`' >( p, end ) ) != end; ++p )
+	{
+		switch ( *p )
+		{
+		case '|': if ( c == text_context::table_cell ) return p; break;
+		case '_': if ( p == begin || p + 1 == end || !is_word_char( p[ -1 ] ) || !is_word_char( p[ 1 ] ) ) return p; break;
+		default: return p;
+		}
+	}
+	return end;
+}
+
+bool markdown_emitter::is_plain( std::string_view s, text_context c )
+{
+	return find_markdown_markup( s.data(), s.data(), s.data() + s.size(), c ) == s.data() + s.size();
+}
+
+template< typename S > void markdown_emitter::text( S& out, std::string_view s, text_context c )
+{
+	auto begin = s.data(), p = begin, end = begin + s.size();
+	while ( p != end )
+	{
+		auto markup = find_markdown_markup( begin, p, end, c );
+		out.append( p, markup );
+		if ( markup == end )
+			break;
+		out += '\\';
+		out += *markup;
+		p = markup + 1;
+	}
+}
+
+template void markdown_emitter::text( std::string& out, std::string_view s, text_context c );
+template void markdown_emitter::text( std::pmr::string& out, std::string_view s, text_context c );
+
+bool html_emitter::is_plain( std::string_view s, text_context )
+{
+	return scan_for< '<', '>', '&', '"' >( s.data(), s.data() + s.size() ) == s.data() + s.size();
+}
+
+template< typename S > void html_emitter::text( S& out, std::string_view s, text_context )
+{
+	auto p = s.data(), end = s.data() + s.size();
+	while ( p != end )
+	{
+		auto special = scan_for< '<', '>', '&', '"' >( p, end );
+		out.append( p, special );
+		if ( special == end )
+			break;
+		switch ( *special )
+		{
+		case '<': out += "&lt;"; break;
+		case '>': out += "&gt;"; break;
+		case '&': out += "&amp;"; break;
+		case '"': out += "&quot;"; break;
+		}
+		p = special + 1;
+	}
+}
+
+template void html_emitter::text( std::string& out, std::string_view s, text_context c );
+template void html_emitter::text( std::pmr::string& out, std::string_view s, text_context c );
+
+output_format output_format_from_name( const std::string& name )
+{
+	if ( name == "dokuwiki" ) return output_format::dokuwiki;
+	else if ( name == "markdown" ) return output_format::markdown;
+	else if ( name == "html" ) return output_format::html;
+	else xo_error( "Unknown output format: " + name );
+}
+
+const char* default_layout( output_format f )
+{
+	switch ( f )
+	{
+	case output_format::markdown: return markdown_emitter::default_layout;
+	case output_format::html: return html_emitter::default_layout;
+	default: return dokuwiki_emitter::default_layout;
+	}
+}
+
+const char* format_extension( output_format f )
+{
+	switch ( f )
+	{
+	case output_format::markdown: return markdown_emitter::extension;
+	case output_format::html: return html_emitter::extension;
+	default: return dokuwiki_emitter::extension;
+	}
+}
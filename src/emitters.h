@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+enum class output_format { dokuwiki, markdown, html };
+
+/// Where text is placed on a page, which determines what must be escaped.
+/// Text inside verbatim markup is shown as is by most formats, verbatim_cell is verbatim text in a table cell.
+enum class text_context { inline_text, table_cell, link_text, verbatim, verbatim_cell };
+
+/// Opening and closing markup around a piece of text.
+struct markup { const char* open; const char* close; };
+
+/// Emitters define the markup of an output format. They are used as template arguments,
+/// so the page writers are instantiated per format without any runtime dispatch.
+/// Text is appended to std::string or std::pmr::string; is_plain( s, c ) tells if text( out, s, c ) would append s unchanged.
+struct dokuwiki_emitter
+{
+	static constexpr output_format format = output_format::dokuwiki;
+	static constexpr const char* extension = "txt";
+	static constexpr markup emphasis{ "//", "//" };
+	static constexpr markup bold{ "**", "**" };
+	static constexpr markup subscript{ "<sub>", "</sub>" };
+	static constexpr markup verbatim{ "<code>", "</code>" };
+	static constexpr markup list{ "", "\n" };
+	static constexpr markup list_item{ "\n  * ", "" };
+	static bool is_plain( std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void text( S& out, std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void link( S& out, std::string_view target, std::string_view text ) {
+		out += "[["; out += target; out += "|"; out += text; out += "]]";
+	}
+	static const char* default_layout;
+};
+
+struct markdown_emitter
+{
+	static constexpr output_format format = output_format::markdown;
+	static constexpr const char* extension = "md";
+	static constexpr markup emphasis{ "*", "*" };
+	static constexpr markup bold{ "**", "**" };
+	static constexpr markup subscript{ "<sub>", "</sub>" };
+	static constexpr markup verbatim{ "`", "`" };
+	static constexpr markup list{ "", "\n" };
+	static constexpr markup list_item{ "\n- ", "" };
+	static bool is_plain( std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void text( S& out, std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void link( S& out, std::string_view target, std::string_view text ) {
+		out += "["; out += text; out += "]("; out += target; out += ".md)";
+	}
+	static const char* default_layout;
+};
+
+struct html_emitter
+{
+	static constexpr output_format format = output_format::html;
+	static constexpr const char* extension = "html";
+	static constexpr markup emphasis{ "<em>", "</em>" };
+	static constexpr markup bold{ "<b>", "</b>" };
+	static constexpr markup subscript{ "<sub>", "</sub>" };
+	static constexpr markup verbatim{ "<pre>", "</pre>" };
+	static constexpr markup list{ "<ul>", "</ul>" };
+	static constexpr markup list_item{ "<li>", "</li>" };
+	static bool is_plain( std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void text( S& out, std::string_view s, text_context c = text_context::inline_text );
+	template< typename S > static void link( S& out, std::string_view target, std::string_view text ) {
+		out += "<a href=\""; html_emitter::text( out, target ); out += ".html\">"; out += text; out += "</a>";
+	}
+	static const char* default_layout;
+};
+
+/// Get output format from its name, throws if the name is unknown.
+output_format output_format_from_name( const std::string& name );
+
+/// Default page layout of an output format.
+const char* default_layout( output_format f );
+
+/// File extension of the pages of an output format.
+const char* format_extension( output_format f );
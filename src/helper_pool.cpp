@@ -0,0 +1,75 @@
+#include "helper_pool.h"
+
+#include <algorithm>
+
+helper_pool::helper_pool( int num_threads )
+{
+	for ( int i = 0; i < num_threads; ++i )
+		threads_.emplace_back( &helper_pool::help, this );
+}
+
+helper_pool::~helper_pool()
+{
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		stopping_ = true;
+	}
+	task_added_.notify_all();
+	for ( auto& t : threads_ )
+		t.join();
+}
+
+void helper_pool::work( task& t )
+{
+	for ( size_t i; ( i = t.next.fetch_add( 1 ) ) < t.n; )
+		( *t.f )( i );
+}
+
+void helper_pool::run( size_t n, const std::function< void( size_t ) >& f )
+{
+	task t;
+	t.n = n;
+	t.f = &f;
+	if ( threads_.empty() || n < 2 )
+	{
+		work( t );
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		tasks_.push_back( &t );
+	}
+	task_added_.notify_all();
+	work( t );
+
+	// all parts are claimed, those claimed by helpers are done when the helpers leave the task
+	std::unique_lock< std::mutex > lock( mutex_ );
+	tasks_.erase( std::remove( tasks_.begin(), tasks_.end(), &t ), tasks_.end() );
+	helper_done_.wait( lock, [&]() { return t.helpers == 0; } );
+}
+
+void helper_pool::help()
+{
+	std::unique_lock< std::mutex > lock( mutex_ );
+	while ( true )
+	{
+		task_added_.wait( lock, [&]() { return stopping_ || !tasks_.empty(); } );
+		if ( stopping_ )
+			return;
+
+		auto& t = *tasks_.front();
+		if ( t.next.load() >= t.n )
+		{
+			// all parts are claimed, the caller waits for the helpers that are still working on it
+			tasks_.erase( tasks_.begin() );
+			continue;
+		}
+		++t.helpers;
+		lock.unlock();
+		work( t );
+		lock.lock();
+		if ( --t.helpers == 0 )
+			helper_done_.notify_all();
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Threads that help workers with parts of a single large page, created once per run.
+/// The parts of a task are claimed one at a time by the calling thread and by idle helpers,
+/// so the caller never waits for a helper that is busy with the task of another worker.
+class helper_pool
+{
+public:
+	/// Create a pool with num_threads helpers; without helpers, tasks run on the calling thread.
+	explicit helper_pool( int num_threads );
+	~helper_pool();
+
+	size_t size() const { return threads_.size(); }
+
+	/// Call f( i ) for all i in [0, n) on the calling thread and idle helpers, returns when all calls are done.
+	/// f must not throw.
+	void run( size_t n, const std::function< void( size_t ) >& f );
+
+private:
+	struct task
+	{
+		size_t n = 0;
+		const std::function< void( size_t ) >* f = nullptr;
+		std::atomic< size_t > next{ 0 };
+		int helpers = 0; // helpers working on the task, guarded by mutex_
+	};
+
+	static void work( task& t );
+	void help();
+
+	std::vector< task* > tasks_; // tasks that may have parts left, oldest first
+	bool stopping_ = false;
+	std::mutex mutex_;
+	std::condition_variable task_added_;
+	std::condition_variable helper_done_;
+	std::vector< std::thread > threads_;
+};
@@ -0,0 +1,158 @@
+#include "inheritance_graph.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+using std::string, std::string_view;
+
+// references in a compound model are stored as link_open, refid, link_text, text, link_close
+inheritance_graph::relation split_ref( string_view ref )
+{
+	auto text = ref.find( char( text_code::link_text ) );
+	auto close = ref.find( char( text_code::link_close ), text );
+	return { string( ref.substr( 1, text - 1 ) ), string( ref.substr( text + 1, close - text - 1 ) ) };
+}
+
+inheritance_graph::compound_entry inheritance_graph::make_entry( string refid, const compound_model& m )
+{
+	compound_entry e;
+	e.refid = std::move( refid );
+	e.name = string( m.str( m.name ) );
+	for ( size_t i = 0; i < m.bases.size(); ++i )
+	{
+		e.bases.push_back( split_ref( m.str( m.bases[ i ] ) ) );
+		e.bases.back().is_public = i >= m.base_protection.size() || m.str( m.base_protection[ i ] ) == "public";
+	}
+	for ( auto& r : m.derived )
+		e.derived.push_back( split_ref( m.str( r ) ) );
+
+	// constructors and destructors are named after the compound, without namespace and template arguments
+	auto short_name = string_view( e.name );
+	short_name = short_name.substr( 0, short_name.find( '<' ) );
+	short_name = short_name.substr( 0, short_name.find_last_not_of( ' ' ) + 1 );
+	if ( auto colon = short_name.rfind( "::" ); colon != string_view::npos )
+		short_name = short_name.substr( colon + 2 );
+
+	std::unordered_set< string_view > added;
+	for ( auto& n : m.functions.name )
+	{
+		auto name = m.str( n );
+		if ( name == short_name || ( name.size() == short_name.size() + 1 && name[ 0 ] == '~' && name.substr( 1 ) == short_name ) )
+			continue;
+		if ( added.insert( name ).second )
+			e.functions.emplace_back( name );
+	}
+	for ( auto& n : m.attributes.name )
+		if ( added.insert( m.str( n ) ).second )
+			e.attributes.emplace_back( m.str( n ) );
+	for ( auto& n : m.other_members )
+		if ( added.insert( m.str( n ) ).second )
+			e.other_members.emplace_back( m.str( n ) );
+	return e;
+}
+
+// sort edges by their source, keeping the order in which they were added, and remove duplicates
+void build_adjacency( std::vector< std::pair< uint32_t, uint32_t > >& edges, size_t num_nodes,
+	std::vector< uint32_t >& offsets, std::vector< uint32_t >& targets )
+{
+	std::stable_sort( edges.begin(), edges.end(), []( auto& a, auto& b ) { return a.first < b.first; } );
+	offsets.assign( num_nodes + 1, 0 );
+	targets.clear();
+	targets.reserve( edges.size() );
+	size_t group_begin = 0;
+	for ( size_t i = 0; i < edges.size(); ++i )
+	{
+		if ( i == 0 || edges[ i ].first != edges[ i - 1 ].first )
+			group_begin = targets.size();
+		if ( std::find( targets.begin() + group_begin, targets.end(), edges[ i ].second ) == targets.end() )
+		{
+			targets.push_back( edges[ i ].second );
+			++offsets[ edges[ i ].first + 1 ];
+		}
+	}
+	for ( size_t n = 0; n < num_nodes; ++n )
+		offsets[ n + 1 ] += offsets[ n ];
+}
+
+inheritance_graph::inheritance_graph( const std::vector< compound_entry >& entries )
+{
+	// nodes are numbered in a fixed order, so pages don't depend on the order in which compounds were read
+	std::vector< string > names;
+	std::vector< const compound_entry* > node_entries;
+	auto add_node = [&]( const string& refid, const string& name ) {
+		auto [ it, inserted ] = index_.try_emplace( refid, node( names.size() ) );
+		if ( inserted )
+		{
+			names.push_back( name );
+			node_entries.push_back( nullptr );
+		}
+		return it->second;
+	};
+	for ( auto& e : entries )
+		if ( !e.refid.empty() )
+		{
+			auto n = add_node( e.refid, e.name );
+			if ( !node_entries[ n ] )
+				node_entries[ n ] = &e;
+		}
+
+	// edges go from derived to base; the protection of an edge is only known from the bases of the derived compound,
+	// which is enough for inherited members, since a derived compound without an entry has no page
+	std::vector< std::pair< node, node > > edges, public_edges;
+	for ( auto& e : entries )
+	{
+		if ( e.refid.empty() || node_entries[ index_[ e.refid ] ] != &e )
+			continue;
+		auto n = index_[ e.refid ];
+		for ( auto& b : e.bases )
+		{
+			edges.emplace_back( n, add_node( b.refid, b.name ) );
+			if ( b.is_public )
+				public_edges.push_back( edges.back() );
+		}
+		for ( auto& d : e.derived )
+			edges.emplace_back( add_node( d.refid, d.name ), n );
+	}
+
+	build_adjacency( edges, names.size(), base_offsets_, base_edges_ );
+	build_adjacency( public_edges, names.size(), public_base_offsets_, public_base_edges_ );
+	for ( auto& e : edges )
+		std::swap( e.first, e.second );
+	build_adjacency( edges, names.size(), derived_offsets_, derived_edges_ );
+
+	links_.resize( names.size() );
+	for ( auto& [ refid, n ] : index_ )
+		links_[ n ] = strings_.add( char( text_code::link_open ) + refid + char( text_code::link_text ) + names[ n ] + char( text_code::link_close ) );
+
+	member_offsets_.assign( 3 * names.size() + 1, 0 );
+	for ( size_t n = 0; n < names.size(); ++n )
+	{
+		auto* e = node_entries[ n ];
+		size_t slot = 3 * n;
+		for ( auto list : { &compound_entry::functions, &compound_entry::attributes, &compound_entry::other_members } )
+		{
+			if ( e )
+				for ( auto& m : e->*list )
+					members_.push_back( strings_.add( m ) );
+			member_offsets_[ ++slot ] = uint32_t( members_.size() );
+		}
+	}
+}
+
+inheritance_graph::node inheritance_graph::find( string_view refid ) const
+{
+	auto it = index_.find( string( refid ) );
+	return it != index_.end() ? it->second : no_node;
+}
+
+std::vector< inheritance_graph::node > inheritance_graph::reachable( const std::vector< uint32_t >& offsets, const std::vector< node >& edges, node n ) const
+{
+	// breadth-first, so nearer compounds come first; cycles in broken input are visited once
+	std::vector< node > result;
+	std::unordered_set< node > visited{ n };
+	for ( size_t i = 0; i <= result.size(); ++i )
+		for ( auto next : adjacent( offsets, edges, i == 0 ? n : result[ i - 1 ] ) )
+			if ( visited.insert( next ).second )
+				result.push_back( next );
+	return result;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "compound_model.h"
+#include "string_pool.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Inheritance relations between all compounds of a run, built once before any page is rendered.
+/// Nodes are numbered and looked up by refid; base and derived edges are stored as compact adjacency arrays.
+class inheritance_graph
+{
+public:
+	using node = uint32_t;
+	static constexpr node no_node = ~node( 0 );
+
+	/// Contiguous elements stored in the graph.
+	template< typename T > struct range
+	{
+		const T* first;
+		const T* last;
+		const T* begin() const { return first; }
+		const T* end() const { return last; }
+		size_t size() const { return size_t( last - first ); }
+		bool empty() const { return first == last; }
+	};
+
+	/// Base or derived compound of an entry.
+	struct relation
+	{
+		std::string refid;
+		std::string name;
+		bool is_public = true; // false for protected and private inheritance
+	};
+
+	/// What the graph needs from a compound, which is much smaller than its model.
+	struct compound_entry
+	{
+		std::string refid;
+		std::string name;
+		std::vector< relation > bases;
+		std::vector< relation > derived;
+		std::vector< std::string > functions; // documented members, without overloads, constructors and destructors
+		std::vector< std::string > attributes;
+		std::vector< std::string > other_members; // names of all other members, which hide inherited members
+	};
+
+	/// Get the entry of compound m, which is read from the file named after refid.
+	static compound_entry make_entry( std::string refid, const compound_model& m );
+
+	inheritance_graph() = default;
+
+	/// Build the graph from entries, which may be empty if the compound could not be read.
+	/// Nodes are numbered in the order of the entries, followed by compounds that are only referred to.
+	explicit inheritance_graph( const std::vector< compound_entry >& entries );
+
+	/// Node of a compound, or no_node if it's not in the graph.
+	node find( std::string_view refid ) const;
+	size_t size() const { return links_.size(); }
+
+	/// Link to the page of n, in the same format as the references in a compound model.
+	std::string_view link( node n ) const { return strings_[ links_[ n ] ]; }
+
+	range< node > bases( node n ) const { return adjacent( base_offsets_, base_edges_, n ); }
+	range< node > derived( node n ) const { return adjacent( derived_offsets_, derived_edges_, n ); }
+	range< pool_string > functions( node n ) const { return members( 3 * n ); }
+	range< pool_string > attributes( node n ) const { return members( 3 * n + 1 ); }
+	range< pool_string > other_members( node n ) const { return members( 3 * n + 2 ); }
+	std::string_view str( pool_string s ) const { return strings_[ s ]; }
+
+	/// All direct and indirect bases of n, nearest first.
+	std::vector< node > ancestors( node n ) const { return reachable( base_offsets_, base_edges_, n ); }
+
+	/// Bases of n whose public members are public members of n, because they are inherited publicly all the way.
+	std::vector< node > public_ancestors( node n ) const { return reachable( public_base_offsets_, public_base_edges_, n ); }
+
+	/// All direct and indirect derived compounds of n, nearest first.
+	std::vector< node > descendants( node n ) const { return reachable( derived_offsets_, derived_edges_, n ); }
+
+private:
+	static range< node > adjacent( const std::vector< uint32_t >& offsets, const std::vector< node >& edges, node n ) {
+		return { edges.data() + offsets[ n ], edges.data() + offsets[ n + 1 ] };
+	}
+	std::vector< node > reachable( const std::vector< uint32_t >& offsets, const std::vector< node >& edges, node n ) const;
+	range< pool_string > members( size_t slot ) const { return { members_.data() + member_offsets_[ slot ], members_.data() + member_offsets_[ slot + 1 ] }; }
+
+	string_pool strings_;
+	std::unordered_map< std::string, node > index_;
+	std::vector< pool_string > links_;
+	std::vector< uint32_t > base_offsets_, derived_offsets_, public_base_offsets_;
+	std::vector< node > base_edges_, derived_edges_, public_base_edges_;
+	std::vector< uint32_t > member_offsets_; // functions, attributes and other members of each node
+	std::vector< pool_string > members_;
+};
@@ -3,10 +3,30 @@
 #include "xo/system/log_sink.h"
 
 #include <tclap/CmdLine.h>
-#include <filesystem>
 #include "xo/serialization/serialize.h"
 #include "xo/container/prop_node.h"
 #include "dokugen.h"
+#include "conversion.h"
+#include "shard.h"
+#include "helper_pool.h"
+#include "arena.h"
+#include "model_cache.h"
+#include "page_sink.h"
+#include "server.h"
+#include "preview_server.h"
+#include "inheritance_graph.h"
+#include "dir_walker.h"
+#include "xml_text.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <unordered_set>
+#ifdef _WIN32
+#	include <fcntl.h>
+#	include <io.h>
+#endif
 #include "xo/filesystem/filesystem.h"
 #include "xo/system/version.h"
 
@@ -17,7 +37,8 @@ const xo::version dokugen_version = xo::version( 1, 0, 1 );
 int main( int argc, char* argv[] )
 {
 	xo::log::console_sink sink( xo::log::level::info );
-	int converted = 0;
+	conversion_summary summary;
+	int exit_code = 0;
 
 	try
 	{
@@ -28,44 +49,248 @@ int main( int argc, char* argv[] )
 		TCLAP::UnlabeledValueArg< string > input( "input", "Folder from where to read XML doxygen output", true, "", "Folder", cmd );
 		TCLAP::UnlabeledValueArg< string > output( "output", "Folder where to write dokuwiki output", false, "", "Folder", cmd );
 		TCLAP::MultiArg< string > remove( "r", "remove", "Remove part of name", false, "String", cmd );
+		TCLAP::ValueArg< int > threads( "j", "threads", "Number of conversion threads (default is number of cores)", false, 0, "Count", cmd );
+		TCLAP::MultiArg< string > formats( "f", "format", "Output format: dokuwiki (default), markdown or html, optionally followed by =layout_file", false, "Format", cmd );
+		TCLAP::ValueArg< string > layout( "l", "layout", "File with a custom dokuwiki page layout", false, "", "File", cmd );
+		TCLAP::ValueArg< string > cache( "c", "cache", "Folder for caching extracted compounds between runs, delete it to clear the cache", false, "", "Folder", cmd );
+		TCLAP::SwitchArg quiet( "q", "quiet", "Only log errors and a final summary", cmd, false );
+		TCLAP::SwitchArg stats( "s", "stats", "Show run statistics", cmd, false );
+		TCLAP::ValueArg< string > shard( "", "shard", "Only convert shard i of N and write a shard manifest to the output folder", false, "", "i/N", cmd );
+		TCLAP::SwitchArg shard_by_size( "", "shard-by-size", "Balance shards by file size instead of filename hash", cmd, false );
+		TCLAP::SwitchArg merge( "", "merge", "Merge the shard manifests in the input folder into a run report in the output folder, and remove them when all shards are present", cmd, false );
+		TCLAP::SwitchArg tar( "t", "tar", "Input is an uncompressed tar file with XML doxygen output, use - to read from stdin", cmd, false );
+		TCLAP::SwitchArg recursive( "R", "recursive", "Also read XML files from subfolders of the input folder (for doxygen CREATE_SUBDIRS)", cmd, false );
+		TCLAP::SwitchArg inheritance( "i", "inheritance", "Read all compounds before converting, to also list indirect base and derived classes and inherited members", cmd, false );
+		TCLAP::SwitchArg staging( "", "staging", "Write pages to <output>.staging and replace the output folder with it when done, keeping files the run did not write", cmd, false );
+		TCLAP::SwitchArg dry_run( "n", "dry-run", "Convert without writing output, report errors and references to compounds without a page", cmd, false );
+		TCLAP::SwitchArg serve( "", "serve", "Serve conversion requests on the Unix domain socket given as input, until a client sends shutdown", cmd, false );
+		TCLAP::ValueArg< int > preview( "", "preview", "Serve pages rendered on request from the input folder over HTTP on localhost:port", false, 0, "Port", cmd );
+		TCLAP::ValueArg< int > preview_cache( "", "preview-cache", "Memory for cached preview pages in MB (default is 64)", false, 64, "MB", cmd );
+		TCLAP::ValueArg< double > file_timeout( "", "file-timeout", "Abandon the conversion of a file after this many seconds", false, 0, "Seconds", cmd );
 		cmd.parse( argc, argv );
 
+		if ( merge.getValue() )
+		{
+			auto report_dir = path( output.getValue().empty() ? input.getValue() : output.getValue() );
+			auto manifests = find_shard_manifests( path( input.getValue() ) );
+			xo::create_directories( report_dir );
+			auto merged = merge_shard_manifests( manifests, report_dir / path( "dokugen-report.txt" ) );
+			return merged.complete && merged.summary.failed == 0 ? 0 : 1;
+		}
+
+		shard_spec shard_cfg;
+		if ( shard.isSet() )
+			shard_cfg = parse_shard_spec( shard.getValue(), shard_by_size.getValue() );
+
 		dokugen_settings cfg;
 		cfg.output_dir = path( output.getValue() );
-		xo::create_directories( cfg.output_dir );
-		for ( auto& r : remove )
-			cfg.remove_strings.emplace_back( r );
+		std::shared_ptr< null_sink > dry_run_sink;
+		path publish_dir;
+		if ( dry_run.getValue() )
+			cfg.sink = dry_run_sink = std::make_shared< null_sink >();
+		else if ( !serve.getValue() && !preview.isSet() )
+		{
+			// with staging, readers of the output folder never see a mix of previous and new pages
+			if ( staging.getValue() )
+			{
+				xo_error_if( output.getValue().empty(), "Staging requires an output folder" );
+				xo_error_if( shard.isSet(), "Shards cannot be staged, since they share the output folder" );
+				publish_dir = cfg.output_dir;
+				cfg.output_dir = staging_dir( publish_dir );
+				std::filesystem::remove_all( cfg.output_dir.str() ); // left by an aborted run
+			}
+			xo::create_directories( cfg.output_dir );
+			cfg.sink = std::make_shared< file_sink >( cfg.output_dir );
+		}
+		cfg.remove_strings = std::make_shared< remove_matcher >( remove.getValue() );
+		for ( auto& f : formats )
+		{
+			auto eq = f.find( '=' );
+			auto format = output_format_from_name( f.substr( 0, eq ) );
+			auto layout_text = eq != string::npos ? load_string( path( f.substr( eq + 1 ) ) ) : default_layout( format );
+			cfg.outputs.push_back( { format, page_layout( layout_text ) } );
+		}
+		if ( cfg.outputs.empty() )
+			cfg.outputs.push_back( { output_format::dokuwiki, page_layout( default_layout( output_format::dokuwiki ) ) } );
+		if ( !layout.getValue().empty() )
+			for ( auto& o : cfg.outputs )
+				if ( o.format == output_format::dokuwiki )
+					o.layout = page_layout( load_string( path( layout.getValue() ) ) );
+
+		if ( !cache.getValue().empty() )
+		{
+			cfg.cache_dir = path( cache.getValue() );
+			xo::create_directories( cfg.cache_dir );
+			if ( auto pruned = prune_model_cache( cfg.cache_dir ); pruned > 0 && !quiet.getValue() )
+				log::info( "Removed ", pruned, " outdated files from the model cache" );
+		}
+
+		conversion_settings run;
+		run.num_threads = threads.getValue();
+		run.quiet = quiet.getValue();
+		run.file_timeout = file_timeout.getValue();
+
+		// helpers are idle unless a worker renders a large member table, so they mostly use the cores of idle workers
+		cfg.helpers = std::make_shared< helper_pool >( worker_count( run ) - 1 );
+
+		if ( serve.getValue() )
+		{
+			// output folder and remove strings are set per request
+			serve_conversions( input.getValue(), cfg, run );
+			return 0;
+		}
+
+		if ( preview.isSet() )
+		{
+			serve_preview( path( input.getValue() ), preview.getValue(), size_t( preview_cache.getValue() ) << 20, cfg, run );
+			return 0;
+		}
+
+		// the graph contains all compounds, also those of other shards
+		auto build_graph = [&]( const std::vector< path >& files ) {
+			cfg.graph = build_inheritance_graph( files, cfg, run );
+			if ( !run.quiet )
+				log::info( "Read the inheritance graph of ", cfg.graph->size(), " compounds" );
+		};
+
+		// a sharded dry run only renders its own pages, references to pages of other shards are resolved against their input files
+		auto add_other_shard_pages = [&]( const std::vector< path >& files, const std::function< bool( const path& ) >& in_this_shard ) {
+			for ( auto& f : files )
+			{
+				if ( in_this_shard( f ) )
+					continue;
+				auto contents = read_input_file( f );
+				if ( contents && !has_empty_brief( *contents ) )
+				{
+					auto name = fix_string( f.filename().str(), cfg );
+					dry_run_sink->add_page( name.substr( 0, name.rfind( '.' ) ) );
+				}
+			}
+		};
 
-		for ( auto& e : std::filesystem::directory_iterator( input.getValue() ) )
+		auto start_time = std::chrono::steady_clock::now();
+		std::vector< conversion_result > results;
+		if ( tar.getValue() )
 		{
-			auto input_path = xo::path( e.path().string() );
-			auto filename = input_path.filename().str();
-			if ( input_path.extension_no_dot() != "xml" )
-				continue;
-			if ( !str_begins_with( filename, "class" ) && !str_begins_with( filename, "struct" ) )
-				continue;
-
-			try
+			xo_error_if( shard_cfg.by_size, "Shards cannot be balanced by size when reading from a tar stream" );
+			xo_error_if( inheritance.getValue(), "The inheritance graph cannot be built when reading from a tar stream" );
+			xo_error_if( dry_run_sink && shard_cfg.enabled(), "A shard cannot be dry run from a tar stream, since references to other shards cannot be checked" );
+			auto select = [&]( const string& name ) { return !shard_cfg.enabled() || in_shard( path( name ), shard_cfg ); };
+			if ( input.getValue() == "-" )
 			{
-				auto n = write_doku( input_path, cfg );
-				log::info( input_path.str(), ": ", n, " elements converted" );
-				++converted;
+#ifdef _WIN32
+				_setmode( _fileno( stdin ), _O_BINARY );
+#endif
+				results = convert_tar( std::cin, cfg, run, select );
 			}
-			catch ( std::exception& e )
+			else
 			{
-				log::error( input_path.str(), ": ", e.what() );
+				std::ifstream tar_stream( input.getValue(), std::ios::binary );
+				xo_error_if( !tar_stream.good(), "Could not open " + input.getValue() );
+				results = convert_tar( tar_stream, cfg, run, select );
 			}
 		}
+		else if ( recursive.getValue() )
+		{
+			xo_error_if( shard_cfg.by_size, "Shards cannot be balanced by size when reading recursively" );
+			auto select = [&]( const path& file ) { return !shard_cfg.enabled() || in_shard( file, shard_cfg ); };
+			if ( inheritance.getValue() || ( dry_run_sink && shard_cfg.enabled() ) )
+			{
+				std::mutex files_mutex;
+				std::vector< path > files;
+				auto walk_threads = std::clamp( run.num_threads > 0 ? run.num_threads : int( std::thread::hardware_concurrency() ), 1, 16 );
+				walk_input_files( path( input.getValue() ), walk_threads, [&]( const path& file ) {
+					std::lock_guard< std::mutex > lock( files_mutex );
+					files.push_back( file );
+				} );
+				std::sort( files.begin(), files.end(), []( const path& a, const path& b ) { return a.str() < b.str(); } );
+				if ( inheritance.getValue() )
+					build_graph( files );
+				if ( dry_run_sink && shard_cfg.enabled() )
+					add_other_shard_pages( files, select );
+			}
+			results = convert_tree( path( input.getValue() ), cfg, run, select );
+		}
+		else
+		{
+			auto files = find_input_files( path( input.getValue() ) );
+			auto selected = shard_cfg.enabled() ? select_shard( files, shard_cfg ) : files;
+			if ( inheritance.getValue() )
+				build_graph( files );
+			if ( dry_run_sink && shard_cfg.enabled() )
+			{
+				std::unordered_set< string > selected_set;
+				for ( auto& f : selected )
+					selected_set.insert( f.str() );
+				add_other_shard_pages( files, [&]( const path& file ) { return selected_set.count( file.str() ) > 0; } );
+			}
+			if ( shard_cfg.enabled() )
+				log::info( "Converting shard ", shard_cfg.name(), ": ", selected.size(), " files" );
+			results = convert_files( selected, cfg, run );
+		}
+		summary = summarize( results );
+
+		if ( summary.count( conversion_error::timed_out ) > 0 )
+		{
+			log::error( summary.count( conversion_error::timed_out ), " files exceeded the time budget of ", run.file_timeout, " seconds:" );
+			for ( auto& r : results )
+				if ( r.error_code == conversion_error::timed_out )
+					log::error( "  ", r.input.str(), " (", r.duration, "s)" );
+		}
+
+		if ( dry_run_sink )
+		{
+			auto dangling = dry_run_sink->dangling_references();
+			for ( auto& d : dangling )
+				log::error( d.page, ": reference to ", d.target, ", which has no page" );
+			log::info( "Dry run: ", dry_run_sink->files(), " files with ", dry_run_sink->bytes(), " bytes rendered, ",
+				dangling.size(), " dangling references" );
+			if ( summary.failed > 0 || !dangling.empty() )
+				exit_code = 1;
+		}
+
+		if ( shard_cfg.enabled() && !dry_run_sink )
+		{
+			auto duration = std::chrono::duration< double >( std::chrono::steady_clock::now() - start_time ).count();
+			auto manifest = write_shard_manifest( cfg.output_dir, shard_cfg, results, duration );
+			log::info( "Shard manifest written to ", manifest.str() );
+		}
+
+		if ( !publish_dir.empty() )
+		{
+			auto kept = publish_staging_dir( cfg.output_dir, publish_dir );
+			log::info( "Published ", cfg.output_dir.str(), " to ", publish_dir.str() );
+			if ( kept > 0 )
+				log::warning( "Kept ", kept, " files in ", publish_dir.str(), " that were not written by this run" );
+		}
+
+		if ( stats.getValue() )
+		{
+			auto st = cfg.interner->stats();
+			log::info( "Interned strings: ", st.entries, " entries, ", st.bytes, " bytes, hit rate ", 100 * st.hit_rate(), "% (",
+				st.local_hits, " local hits, ", st.shared_hits, " shared hits, ", st.misses, " misses)" );
+			auto ast = arena::stats();
+			log::info( "XML arenas: ", ast.peak_reserved, " bytes reserved in ", ast.regions, " regions (", ast.huge_page_regions,
+				" with huge pages), high-water mark ", ast.high_water, " bytes, ", ast.overflows, " regions grown" );
+		}
 	}
 	catch ( std::exception& e )
 	{
 		log::critical( e.what() );
+		exit_code = 1;
 	}
 	catch ( TCLAP::ExitException& e )
 	{
 		return e.getExitStatus();
 	}
 
-	log::info( "Successfully converted ", converted, " files..." );
-	return 0;
+	log::info( "Successfully converted ", summary.converted, " files (", summary.elements, " elements)..." );
+	if ( summary.failed > 0 )
+	{
+		log::error( "Failed to convert ", summary.failed, " files" );
+		for ( size_t e = 1; e < size_t( conversion_error::count ); ++e )
+			if ( summary.errors[ e ] > 0 )
+				log::error( "  ", summary.errors[ e ], " ", error_description( conversion_error( e ) ) );
+	}
+	return exit_code;
 }
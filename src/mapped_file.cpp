@@ -0,0 +1,77 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#	include <fstream>
+#	include <sstream>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+mapped_file::mapped_file( const std::string& filename )
+{
+#ifdef _WIN32
+	std::ifstream str( filename, std::ios::binary );
+	if ( !str.good() )
+		return;
+	std::stringstream buf;
+	buf << str.rdbuf();
+	buffer_ = buf.str();
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+#else
+	int fd = ::open( filename.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return;
+	struct stat st;
+	if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+	{
+		auto* p = mmap( nullptr, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( p != MAP_FAILED )
+		{
+			data_ = static_cast<const char*>( p );
+			size_ = size_t( st.st_size );
+		}
+	}
+	::close( fd );
+#endif
+}
+
+mapped_file::mapped_file( mapped_file&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+mapped_file& mapped_file::operator=( mapped_file&& other ) noexcept
+{
+	if ( this != &other )
+	{
+		close();
+		std::swap( data_, other.data_ );
+		std::swap( size_, other.size_ );
+		std::swap( buffer_, other.buffer_ );
+		if ( !buffer_.empty() )
+			data_ = buffer_.data();
+	}
+	return *this;
+}
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+void mapped_file::close()
+{
+#ifndef _WIN32
+	if ( data_ && buffer_.empty() )
+		munmap( const_cast<char*>( data_ ), size_ );
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	buffer_.clear();
+}
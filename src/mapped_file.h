@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/// Read-only view of a file, memory mapped where the platform supports it.
+class mapped_file
+{
+public:
+	mapped_file() = default;
+	explicit mapped_file( const std::string& filename );
+	mapped_file( const mapped_file& ) = delete;
+	mapped_file& operator=( const mapped_file& ) = delete;
+	mapped_file( mapped_file&& other ) noexcept;
+	mapped_file& operator=( mapped_file&& other ) noexcept;
+	~mapped_file();
+
+	bool is_open() const { return data_ != nullptr; }
+	const char* data() const { return data_; }
+	size_t size() const { return size_; }
+	std::string_view view() const { return std::string_view( data_, size_ ); }
+
+private:
+	void close();
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	std::string buffer_; // used when memory mapping is not available
+};
@@ -0,0 +1,188 @@
+#include "model_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#ifdef _WIN32
+#	include <process.h>
+#	define getpid _getpid
+#else
+#	include <unistd.h>
+#endif
+#include "mapped_file.h"
+#include "xo/system/assert.h"
+
+// Cache entries are a header, the string references of the model and its string pool.
+// The string references are stored in column order, the pool is used straight from the memory map.
+const char cache_magic[ 4 ] = { 'D', 'K', 'G', 'C' };
+const uint32_t cache_version = 4; // 4: link targets are decoded
+
+struct cache_header
+{
+	char magic[ 4 ];
+	uint32_t version;
+	uint64_t key;
+	uint32_t base_count;
+	uint32_t derived_count;
+	uint32_t attribute_count;
+	uint32_t function_count;
+	uint32_t other_member_count;
+	uint64_t pool_size;
+};
+
+const size_t columns_per_member = 4;
+
+uint64_t model_cache_key( std::string_view file_contents )
+{
+	// FNV-1a, salted with the cache version so old entries are never used
+	uint64_t h = 14695981039346656037ull ^ cache_version;
+	for ( unsigned char c : file_contents )
+		h = ( h ^ c ) * 1099511628211ull;
+	return h;
+}
+
+// entries are named after their key and the cache version, so entries of other versions can be pruned by name
+const std::string cache_suffix = "-v" + std::to_string( cache_version ) + ".dkc";
+
+xo::path cache_file( const xo::path& cache_dir, uint64_t key )
+{
+	char name[ 24 ];
+	snprintf( name, sizeof( name ), "%016llx", static_cast<unsigned long long>( key ) );
+	return cache_dir / xo::path( name + cache_suffix );
+}
+
+size_t reference_count( const cache_header& h ) {
+	return 3 + 2 * h.base_count + h.derived_count + columns_per_member * ( h.attribute_count + h.function_count ) + h.other_member_count;
+}
+
+bool load_cached_model( const xo::path& cache_dir, uint64_t key, compound_model& m )
+{
+	auto file = std::make_shared< mapped_file >( cache_file( cache_dir, key ).str() );
+	if ( !file->is_open() || file->size() < sizeof( cache_header ) )
+		return false;
+
+	cache_header h;
+	memcpy( &h, file->data(), sizeof( h ) );
+	if ( memcmp( h.magic, cache_magic, sizeof( cache_magic ) ) != 0 || h.version != cache_version || h.key != key )
+		return false;
+
+	auto pool_begin = sizeof( cache_header ) + reference_count( h ) * sizeof( pool_string );
+	if ( file->size() != pool_begin + h.pool_size )
+		return false;
+
+	auto refs = file->data() + sizeof( cache_header );
+	auto read_column = [&]( std::vector< pool_string >& column, size_t count ) {
+		column.resize( count );
+		memcpy( column.data(), refs, count * sizeof( pool_string ) );
+		refs += count * sizeof( pool_string );
+	};
+	auto read_members = [&]( member_table& members, size_t count ) {
+		read_column( members.name, count );
+		read_column( members.type, count );
+		read_column( members.args, count );
+		read_column( members.brief, count );
+	};
+
+	memcpy( &m.name, refs, sizeof( pool_string ) );
+	memcpy( &m.brief, refs + sizeof( pool_string ), sizeof( pool_string ) );
+	memcpy( &m.detailed, refs + 2 * sizeof( pool_string ), sizeof( pool_string ) );
+	refs += 3 * sizeof( pool_string );
+	read_column( m.bases, h.base_count );
+	read_column( m.base_protection, h.base_count );
+	read_column( m.derived, h.derived_count );
+	read_members( m.attributes, h.attribute_count );
+	read_members( m.functions, h.function_count );
+	read_column( m.other_members, h.other_member_count );
+
+	// reject entries that point outside the pool
+	auto valid = [&]( pool_string s ) { return uint64_t( s.offset ) + s.size <= h.pool_size; };
+	auto valid_column = [&]( const std::vector< pool_string >& c ) { return std::all_of( c.begin(), c.end(), valid ); };
+	auto valid_members = [&]( const member_table& t ) {
+		return valid_column( t.name ) && valid_column( t.type ) && valid_column( t.args ) && valid_column( t.brief );
+	};
+	if ( !valid( m.name ) || !valid( m.brief ) || !valid( m.detailed ) || !valid_column( m.bases ) || !valid_column( m.base_protection )
+		|| !valid_column( m.derived ) || !valid_members( m.attributes ) || !valid_members( m.functions ) || !valid_column( m.other_members ) )
+		return false;
+
+	auto pool = file->data() + pool_begin;
+	m.strings.assign_external( file, pool, size_t( h.pool_size ) );
+	return true;
+}
+
+bool save_cached_model( const xo::path& cache_dir, uint64_t key, const compound_model& m )
+{
+	cache_header h{};
+	memcpy( h.magic, cache_magic, sizeof( cache_magic ) );
+	h.version = cache_version;
+	h.key = key;
+	h.base_count = uint32_t( m.bases.size() );
+	h.derived_count = uint32_t( m.derived.size() );
+	h.attribute_count = uint32_t( m.attributes.size() );
+	h.function_count = uint32_t( m.functions.size() );
+	h.other_member_count = uint32_t( m.other_members.size() );
+	h.pool_size = m.strings.size();
+
+	// write to a temporary file first, so other processes never see a partial entry;
+	// the name is unique per process and write, and the file is created exclusively, so writers never share it
+	static std::atomic< uint64_t > temp_count{ 0 };
+	auto filename = cache_file( cache_dir, key );
+	auto temp_filename = filename.str() + ".tmp." + std::to_string( getpid() ) + "." + std::to_string( temp_count++ );
+	bool ok = false;
+	{
+		auto* file = std::fopen( temp_filename.c_str(), "wbx" );
+		if ( !file )
+			return false;
+		ok = true;
+		auto write = [&]( const void* data, size_t size ) { ok = ok && std::fwrite( data, 1, size, file ) == size; };
+		auto write_column = [&]( const std::vector< pool_string >& column ) { write( column.data(), column.size() * sizeof( pool_string ) ); };
+		auto write_members = [&]( const member_table& members ) {
+			write_column( members.name );
+			write_column( members.type );
+			write_column( members.args );
+			write_column( members.brief );
+		};
+
+		write( &h, sizeof( h ) );
+		write( &m.name, sizeof( pool_string ) );
+		write( &m.brief, sizeof( pool_string ) );
+		write( &m.detailed, sizeof( pool_string ) );
+		write_column( m.bases );
+		write_column( m.base_protection );
+		write_column( m.derived );
+		write_members( m.attributes );
+		write_members( m.functions );
+		write_column( m.other_members );
+		write( m.strings.data(), m.strings.size() );
+		ok = std::fclose( file ) == 0 && ok;
+	}
+	std::error_code ec;
+	if ( ok )
+		std::filesystem::rename( temp_filename, filename.str(), ec );
+	if ( !ok || ec )
+		std::filesystem::remove( temp_filename, ec );
+	return ok && !ec;
+}
+
+size_t prune_model_cache( const xo::path& cache_dir )
+{
+	// temporary files are only this old if their writer was aborted
+	auto temp_expiry = std::filesystem::file_time_type::clock::now() - std::chrono::hours( 1 );
+	size_t removed = 0;
+	std::error_code ec;
+	for ( auto& e : std::filesystem::directory_iterator( cache_dir.str(), ec ) )
+	{
+		auto name = e.path().filename().string();
+		bool stale = false;
+		if ( name.find( ".dkc.tmp." ) != std::string::npos )
+			stale = e.last_write_time( ec ) < temp_expiry && !ec;
+		else if ( name.size() > 4 && name.compare( name.size() - 4, 4, ".dkc" ) == 0 )
+			stale = name.size() < cache_suffix.size() || name.compare( name.size() - cache_suffix.size(), cache_suffix.size(), cache_suffix ) != 0;
+		if ( stale && std::filesystem::remove( e.path(), ec ) )
+			++removed;
+	}
+	return removed;
+}
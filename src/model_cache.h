@@ -0,0 +1,18 @@
+#pragma once
+
+#include "compound_model.h"
+#include "xo/filesystem/path.h"
+#include <cstdint>
+
+/// Key of a cached model, a hash of the input file contents.
+uint64_t model_cache_key( std::string_view file_contents );
+
+/// Load a model from cache_dir, returns false if there is no valid cache entry for key.
+bool load_cached_model( const xo::path& cache_dir, uint64_t key, compound_model& m );
+
+/// Store a model in cache_dir, returns false if the entry could not be written.
+bool save_cached_model( const xo::path& cache_dir, uint64_t key, const compound_model& m );
+
+/// Remove entries of other cache versions and temporary files left by aborted writes, returns the number of files removed.
+/// Entries of inputs that have changed are not detected, delete the cache folder to remove those.
+size_t prune_model_cache( const xo::path& cache_dir );
@@ -0,0 +1,98 @@
+#include "page_layout.h"
+
+#include "xo/system/assert.h"
+#include <algorithm>
+
+const char* section_names[] = {
+	"title", "detailed", "inherits_from", "inherited_by", "ancestors", "descendants",
+	"attribute_header", "attribute_row", "attribute_footer",
+	"function_header", "function_row", "function_footer", "inherited_members", "footer"
+};
+
+const char* field_names[] = { "name", "brief", "detailed", "links", "type", "args", "members" };
+
+bool is_identifier( std::string_view s ) {
+	return !s.empty() && std::all_of( s.begin(), s.end(), []( char c ) { return ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) || c == '_'; } );
+}
+
+template< typename T, size_t N > int find_name( const T( &names )[ N ], std::string_view name ) {
+	for ( size_t i = 0; i < N; ++i )
+		if ( name == names[ i ] )
+			return int( i );
+	return -1;
+}
+
+page_layout::page_layout( std::string layout_text ) :
+	source_( std::move( layout_text ) )
+{
+	std::vector< segment >* cur = nullptr;
+	auto add_literal = [&]( size_t begin, size_t end ) {
+		if ( end <= begin ) return;
+		if ( !cur->empty() && cur->back().field == layout_field::count && cur->back().offset + cur->back().size == begin )
+			cur->back().size += end - begin; // extend previous literal
+		else cur->push_back( segment{ begin, end - begin, layout_field::count } );
+	};
+
+	for ( size_t line_begin = 0; line_begin < source_.size(); )
+	{
+		auto line_end = source_.find( '\n', line_begin );
+		line_end = line_end == std::string::npos ? source_.size() : line_end + 1;
+		std::string_view line( source_.data() + line_begin, line_end - line_begin );
+
+		// section header
+		auto header = line.substr( 0, line.find_last_not_of( " \t\r\n" ) + 1 );
+		header.remove_prefix( std::min( header.find_first_not_of( " \t" ), header.size() ) );
+		if ( header.size() >= 2 && header.front() == '[' && header.back() == ']' && is_identifier( header.substr( 1, header.size() - 2 ) ) )
+		{
+			auto name = header.substr( 1, header.size() - 2 );
+			auto idx = find_name( section_names, name );
+			xo_error_if( idx < 0, "Unknown layout section: " + std::string( name ) );
+			cur = &sections_[ idx ];
+			cur->clear();
+			line_begin = line_end;
+			continue;
+		}
+		xo_error_if( !cur, "Layout text must start with a [section] header" );
+
+		// template line
+		auto pos = line_begin;
+		while ( pos < line_end )
+		{
+			auto brace = source_.find( '{', pos );
+			if ( brace >= line_end ) {
+				add_literal( pos, line_end );
+				break;
+			}
+			add_literal( pos, brace );
+			if ( brace + 1 < line_end && source_[ brace + 1 ] == '{' ) {
+				// DokuWiki media
+				auto media_end = source_.find( "}}", brace + 2 );
+				pos = media_end < line_end ? media_end + 2 : brace + 2;
+				add_literal( brace, pos );
+				continue;
+			}
+			auto close = source_.find( '}', brace );
+			auto name = std::string_view( source_ ).substr( brace + 1, std::min( close, line_end ) - brace - 1 );
+			if ( close >= line_end || !is_identifier( name ) ) {
+				add_literal( brace, brace + 1 );
+				pos = brace + 1;
+				continue;
+			}
+			auto idx = find_name( field_names, name );
+			xo_error_if( idx < 0, "Unknown layout field: " + std::string( name ) );
+			cur->push_back( segment{ 0, 0, layout_field( idx ) } );
+			pos = close + 1;
+		}
+		line_begin = line_end;
+	}
+}
+
+void page_layout::render( section s, page_slices& out, const layout_values& values ) const
+{
+	for ( auto& seg : sections_[ s ] )
+	{
+		if ( seg.field == layout_field::count )
+			out.append( std::string_view( source_.data() + seg.offset, seg.size ) );
+		else out.append( values[ size_t( seg.field ) ] );
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "page_slices.h"
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class layout_field { name, brief, detailed, links, type, args, members, count };
+using layout_values = std::array< std::string_view, size_t( layout_field::count ) >;
+
+/// Layout of a generated page, from a text with [section] headers followed by template lines.
+/// A header is a line with only [name]; other lines starting with [, such as DokuWiki links, are template lines.
+/// Template lines contain {field} slots. Other braces are literal, and {{...}} is copied as is, since it is
+/// DokuWiki media syntax. There is no escape for a literal {field}.
+/// The text is compiled once into a list of literal slices and field slots per section.
+class page_layout
+{
+public:
+	enum section {
+		title, detailed, inherits_from, inherited_by, ancestors, descendants,
+		attribute_header, attribute_row, attribute_footer,
+		function_header, function_row, function_footer, inherited_members, footer,
+		section_count
+	};
+
+	explicit page_layout( std::string layout_text );
+
+	/// Append section s to out, with field slots replaced by values; values must stay valid until the page is written.
+	void render( section s, page_slices& out, const layout_values& values = {} ) const;
+
+private:
+	struct segment {
+		size_t offset; // position of literal in source_
+		size_t size;
+		layout_field field; // layout_field::count for literals
+	};
+
+	std::string source_;
+	std::array< std::vector< segment >, section_count > sections_;
+};
@@ -0,0 +1,294 @@
+#include "page_sink.h"
+
+#include "xo/system/assert.h"
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+
+#include <process.h>
+
+int process_id() { return _getpid(); }
+
+file_sink::file_sink( const xo::path& dir ) : dir_( dir ) {}
+
+file_sink::~file_sink() {}
+
+bool file_sink::write( const xo::path& filename, const page_slices& page )
+{
+	// text mode, like the pages have always been written on Windows
+	auto temp = temp_name( filename.str() );
+	{
+		std::ofstream str( temp );
+		for ( auto& s : page.slices() )
+			str.write( s.data(), s.size() );
+		if ( !str.good() )
+			return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename( temp, filename.str(), ec );
+	if ( ec )
+		std::filesystem::remove( temp, ec );
+	return !ec;
+}
+
+#else
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef IOV_MAX
+const size_t max_iovecs = IOV_MAX;
+#else
+const size_t max_iovecs = 1024;
+#endif
+
+int process_id() { return int( ::getpid() ); }
+
+// renameat2 flag, which older C libraries don't define
+const unsigned int rename_exchange = 1 << 1;
+
+bool write_slices( int fd, const page_slices& page )
+{
+	auto& slices = page.slices();
+	iovec iov[ 64 ];
+	const size_t batch_size = std::min< size_t >( 64, max_iovecs );
+	for ( size_t i = 0; i < slices.size(); )
+	{
+		size_t n = 0;
+		for ( ; n < batch_size && i + n < slices.size(); ++n )
+			iov[ n ] = iovec{ const_cast< char* >( slices[ i + n ].data() ), slices[ i + n ].size() };
+		i += n;
+
+		// writev may write only part of the batch
+		iovec* v = iov;
+		while ( n > 0 )
+		{
+			auto written = ::writev( fd, v, int( n ) );
+			if ( written < 0 )
+			{
+				if ( errno == EINTR )
+					continue;
+				return false;
+			}
+			auto left = size_t( written );
+			for ( ; n > 0 && left >= v->iov_len; ++v, --n )
+				left -= v->iov_len;
+			if ( n > 0 )
+			{
+				v->iov_base = static_cast< char* >( v->iov_base ) + left;
+				v->iov_len -= left;
+			}
+		}
+	}
+	return true;
+}
+
+file_sink::file_sink( const xo::path& dir ) :
+	dir_( dir ),
+	dir_fd_( ::open( dir.empty() ? "." : dir.str().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC ) )
+{
+	xo_error_if( dir_fd_ < 0, "Could not open " + dir.str() );
+}
+
+file_sink::~file_sink()
+{
+	if ( dir_fd_ >= 0 )
+		::close( dir_fd_ );
+}
+
+// write page to temp, as an unnamed file that only gets its name once it is complete, where supported
+bool write_temp( int dir_fd, const std::string& name, const std::string& temp, const page_slices& page, std::atomic< bool >& use_tmpfile )
+{
+#ifdef O_TMPFILE
+	if ( use_tmpfile )
+	{
+		auto slash = name.rfind( '/' );
+		auto dir = slash == std::string::npos ? std::string( "." ) : name.substr( 0, std::max< size_t >( slash, 1 ) );
+		int fd = ::openat( dir_fd, dir.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666 );
+		if ( fd >= 0 )
+		{
+			bool ok = write_slices( fd, page );
+			auto proc_path = "/proc/self/fd/" + std::to_string( fd );
+			bool linked = ok && ::linkat( AT_FDCWD, proc_path.c_str(), dir_fd, temp.c_str(), AT_SYMLINK_FOLLOW ) == 0;
+			auto link_error = errno;
+			::close( fd );
+			if ( linked )
+				return true;
+			if ( !ok || link_error != ENOENT )
+				return false;
+			use_tmpfile = false; // no /proc
+		}
+		else if ( errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL )
+			use_tmpfile = false; // not supported by the file system
+		else return false;
+	}
+#endif
+
+	int fd = ::openat( dir_fd, temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666 );
+	if ( fd < 0 )
+		return false;
+	bool ok = write_slices( fd, page );
+	if ( ::close( fd ) != 0 || !ok )
+	{
+		::unlinkat( dir_fd, temp.c_str(), 0 );
+		return false;
+	}
+	return true;
+}
+
+bool file_sink::write( const xo::path& filename, const page_slices& page )
+{
+	// pages in dir_ are opened relative to its handle, others by their full path
+	int dir_fd = AT_FDCWD;
+	auto name = filename.str();
+	if ( dir_fd_ >= 0 && filename.parent_path() == dir_ )
+	{
+		dir_fd = dir_fd_;
+		name = filename.filename().str();
+	}
+
+	auto temp = temp_name( name );
+	if ( !write_temp( dir_fd, name, temp, page, use_tmpfile_ ) )
+		return false;
+	if ( ::renameat( dir_fd, temp.c_str(), dir_fd, name.c_str() ) != 0 )
+	{
+		::unlinkat( dir_fd, temp.c_str(), 0 );
+		return false;
+	}
+	return true;
+}
+
+#endif
+
+std::string file_sink::temp_name( const std::string& name )
+{
+	// hidden and next to the page, unique within the run and among runs that write the same page
+	auto dir_size = name.find_last_of( "/\\" ) + 1;
+	return name.substr( 0, dir_size ) + '.' + name.substr( dir_size ) + '.' + std::to_string( process_id() ) + '-'
+		+ std::to_string( temp_count_++ ) + ".tmp";
+}
+
+xo::path staging_dir( const xo::path& output_dir )
+{
+	auto dir = output_dir.str();
+	while ( dir.size() > 1 && ( dir.back() == '/' || dir.back() == '\\' ) )
+		dir.pop_back();
+	return xo::path( dir + ".staging" );
+}
+
+// copy the files of output_dir that the run did not write into staging, so publishing keeps them
+size_t copy_other_files( const xo::path& staging, const xo::path& output_dir )
+{
+	namespace fs = std::filesystem;
+	size_t count = 0;
+	fs::path from( output_dir.str() ), to( staging.str() );
+	for ( auto it = fs::recursive_directory_iterator( from ); it != fs::recursive_directory_iterator(); ++it )
+	{
+		if ( it->is_directory() && !it->is_symlink() )
+			continue;
+		auto target = to / it->path().lexically_relative( from );
+		if ( fs::exists( fs::symlink_status( target ) ) )
+			continue;
+		std::error_code ec;
+		fs::create_directories( target.parent_path(), ec );
+		if ( it->is_symlink() )
+			fs::copy_symlink( it->path(), target, ec );
+		else
+			fs::copy_file( it->path(), target, ec );
+		xo_error_if( ec, "Could not copy " + it->path().string() + " to " + target.string() + ": " + ec.message() );
+		++count;
+	}
+	return count;
+}
+
+size_t publish_staging_dir( const xo::path& staging, const xo::path& output_dir )
+{
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	if ( !fs::exists( output_dir.str(), ec ) )
+	{
+		fs::rename( staging.str(), output_dir.str(), ec );
+		xo_error_if( ec, "Could not move " + staging.str() + " to " + output_dir.str() + ": " + ec.message() );
+		return 0;
+	}
+	auto kept = copy_other_files( staging, output_dir );
+
+#if defined( __linux__ ) && defined( SYS_renameat2 )
+	// exchange both folders in one step, so readers see either all previous or all new pages
+	if ( ::syscall( SYS_renameat2, AT_FDCWD, staging.str().c_str(), AT_FDCWD, output_dir.str().c_str(), rename_exchange ) == 0 )
+	{
+		fs::remove_all( staging.str(), ec );
+		return kept;
+	}
+#endif
+
+	// otherwise the previous pages are moved aside first, the output folder is missing in between
+	auto previous = fs::path( staging.str() ).replace_extension( ".previous" ).string();
+	fs::remove_all( previous, ec );
+	fs::rename( output_dir.str(), previous, ec );
+	xo_error_if( ec, "Could not move " + output_dir.str() + ": " + ec.message() );
+	fs::rename( staging.str(), output_dir.str(), ec );
+	if ( ec )
+	{
+		auto error = ec.message();
+		fs::rename( previous, output_dir.str(), ec );
+		xo_error( "Could not move " + staging.str() + " to " + output_dir.str() + ": " + error );
+	}
+	fs::remove_all( previous, ec );
+	return kept;
+}
+
+bool memory_sink::write( const xo::path& filename, const page_slices& page )
+{
+	auto contents = page.str();
+	std::lock_guard< std::mutex > lock( mutex_ );
+	pages_.emplace_back( filename, std::move( contents ) );
+	return true;
+}
+
+std::vector< std::pair< xo::path, std::string > > memory_sink::pages() const
+{
+	std::lock_guard< std::mutex > lock( mutex_ );
+	return pages_;
+}
+
+bool null_sink::write( const xo::path& filename, const page_slices& page )
+{
+	files_.fetch_add( 1, std::memory_order_relaxed );
+	bytes_.fetch_add( page.size(), std::memory_order_relaxed );
+
+	// the page is known by its compound id, the filename without extension
+	auto name = filename.filename().str();
+	std::lock_guard< std::mutex > lock( mutex_ );
+	pages_.emplace( name.substr( 0, name.rfind( '.' ) ) );
+	return true;
+}
+
+void null_sink::add_reference( std::string_view page, std::string_view target )
+{
+	std::lock_guard< std::mutex > lock( mutex_ );
+	if ( references_.find( target ) == references_.end() )
+		references_.emplace( std::string( target ), std::string( page ) );
+}
+
+void null_sink::add_page( std::string name )
+{
+	std::lock_guard< std::mutex > lock( mutex_ );
+	pages_.emplace( std::move( name ) );
+}
+
+std::vector< null_sink::dangling_reference > null_sink::dangling_references() const
+{
+	std::lock_guard< std::mutex > lock( mutex_ );
+	std::vector< dangling_reference > result;
+	for ( auto& [ target, page ] : references_ )
+		if ( pages_.find( target ) == pages_.end() )
+			result.push_back( { page, target } );
+	return result;
+}
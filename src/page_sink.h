@@ -0,0 +1,101 @@
+#pragma once
+
+#include "xo/filesystem/path.h"
+#include "page_slices.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Destination of rendered pages, must be thread-safe.
+class page_sink
+{
+public:
+	virtual ~page_sink() = default;
+
+	/// Write a page, returns false if it could not be written.
+	virtual bool write( const xo::path& filename, const page_slices& page ) = 0;
+
+	/// Called for each compound a page links to; page and target are compound ids.
+	virtual void add_reference( std::string_view, std::string_view ) {}
+};
+
+/// Writes pages to files, gathering the slices of a page with writev where available.
+/// A page is written to a temporary file that is renamed into place, so readers never see a partial page.
+/// Pages in dir are opened relative to a handle of dir, instead of resolving the full path of each page.
+class file_sink : public page_sink
+{
+public:
+	file_sink() = default;
+	explicit file_sink( const xo::path& dir );
+	file_sink( const file_sink& ) = delete;
+	file_sink& operator=( const file_sink& ) = delete;
+	~file_sink() override;
+
+	bool write( const xo::path& filename, const page_slices& page ) override;
+
+private:
+	std::string temp_name( const std::string& name );
+
+	xo::path dir_;
+	int dir_fd_ = -1;
+	std::atomic< bool > use_tmpfile_{ true };
+	std::atomic< uint64_t > temp_count_{ 0 };
+};
+
+/// Folder next to output_dir where pages are rendered before they are published.
+xo::path staging_dir( const xo::path& output_dir );
+
+/// Replace output_dir by staging, in a single step where the platform supports it; throws on failure.
+/// Files in output_dir that staging doesn't have are copied into staging first, so only the pages of the run are replaced.
+/// Returns the number of files that were kept this way.
+size_t publish_staging_dir( const xo::path& staging, const xo::path& output_dir );
+
+/// Keeps pages in memory.
+class memory_sink : public page_sink
+{
+public:
+	bool write( const xo::path& filename, const page_slices& page ) override;
+
+	/// Pages that have been written, as filename and contents.
+	std::vector< std::pair< xo::path, std::string > > pages() const;
+
+private:
+	mutable std::mutex mutex_;
+	std::vector< std::pair< xo::path, std::string > > pages_;
+};
+
+/// Discards pages, but keeps count of them and checks that referenced compounds have a page.
+class null_sink : public page_sink
+{
+public:
+	struct dangling_reference
+	{
+		std::string page;
+		std::string target;
+	};
+
+	bool write( const xo::path& filename, const page_slices& page ) override;
+	void add_reference( std::string_view page, std::string_view target ) override;
+
+	/// Add a page that is not rendered by this run, such as a page of another shard.
+	void add_page( std::string name );
+
+	uint64_t files() const { return files_; }
+	uint64_t bytes() const { return bytes_; }
+
+	/// References to compounds without a page, sorted by target.
+	std::vector< dangling_reference > dangling_references() const;
+
+private:
+	std::atomic< uint64_t > files_{ 0 };
+	std::atomic< uint64_t > bytes_{ 0 };
+	mutable std::mutex mutex_;
+	std::set< std::string, std::less<> > pages_;
+	std::map< std::string, std::string, std::less<> > references_; // target -> first page that references it
+};
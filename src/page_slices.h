@@ -0,0 +1,92 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// String in the memory resource of a page.
+using page_string = std::pmr::string;
+
+/// A rendered page as a list of slices, which is written without first copying it into one buffer.
+/// Slices point into text that outlives the page (the page layout, interned fragments and the compound model)
+/// or into text generated for the page, which is stored in the page's memory resource.
+class page_slices
+{
+public:
+	explicit page_slices( std::pmr::memory_resource* mem ) : slices_( mem ), own_texts_( mem ), texts_( &own_texts_ ) {}
+
+	/// Slices for part of a page, generated text is stored with parent.
+	explicit page_slices( page_slices& parent ) : slices_( parent.resource() ), own_texts_( parent.resource() ), texts_( parent.texts_ ) {}
+
+	page_slices( const page_slices& ) = delete;
+	page_slices& operator=( const page_slices& ) = delete;
+
+	/// Append text that stays valid until the page is written; adjacent slices are merged.
+	void append( std::string_view s ) {
+		if ( s.empty() )
+			return;
+		if ( !slices_.empty() && slices_.back().data() + slices_.back().size() == s.data() )
+			slices_.back() = std::string_view( slices_.back().data(), slices_.back().size() + s.size() );
+		else slices_.push_back( s );
+		size_ += s.size();
+	}
+	page_slices& operator+=( std::string_view s ) { append( s ); return *this; }
+
+	/// New string for generated text, stored with the page; append it once it's complete.
+	page_string& new_text() { return texts_->emplace_back(); }
+
+	/// Append the slices of other, which is kept alive by owner until the page is written.
+	void append( const page_slices& other, std::shared_ptr< void > owner ) {
+		for ( auto& s : other.slices_ )
+			append( s );
+		owners_.push_back( std::move( owner ) );
+	}
+
+	/// The slices as a single view, only copied if there is more than one slice.
+	std::string_view join() {
+		if ( slices_.size() <= 1 )
+			return slices_.empty() ? std::string_view() : slices_.front();
+		auto& text = new_text();
+		text.reserve( size_ );
+		for ( auto& s : slices_ )
+			text += s;
+		return text;
+	}
+
+	/// Mark the current end, to remove what is appended after it with rewind().
+	struct position { size_t slices; size_t last_size; size_t size; };
+	position mark() const { return { slices_.size(), slices_.empty() ? 0 : slices_.back().size(), size_ }; }
+	void rewind( const position& p ) {
+		slices_.resize( p.slices );
+		if ( !slices_.empty() )
+			slices_.back() = std::string_view( slices_.back().data(), p.last_size );
+		size_ = p.size;
+	}
+
+	void reserve( size_t slice_count ) { slices_.reserve( slice_count ); }
+	size_t capacity() const { return slices_.capacity(); }
+
+	const std::pmr::vector< std::string_view >& slices() const { return slices_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	std::pmr::memory_resource* resource() const { return slices_.get_allocator().resource(); }
+
+	/// Copy all slices into one string.
+	std::string str() const {
+		std::string result;
+		result.reserve( size_ );
+		for ( auto& s : slices_ )
+			result += s;
+		return result;
+	}
+
+private:
+	std::pmr::vector< std::string_view > slices_;
+	std::pmr::list< page_string > own_texts_;
+	std::pmr::list< page_string >* texts_;
+	std::vector< std::shared_ptr< void > > owners_;
+	size_t size_ = 0;
+};
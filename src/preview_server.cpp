@@ -0,0 +1,325 @@
+#include "preview_server.h"
+#include "socket_io.h"
+#include "model_cache.h"
+
+#include "xo/system/log.h"
+#include "xo/system/assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <unordered_map>
+
+#ifndef _WIN32
+#	include <arpa/inet.h>
+#	include <netinet/in.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
+
+using namespace xo;
+using std::string;
+
+#ifndef _WIN32
+
+struct http_response
+{
+	int status = 200;
+	string content_type = "text/plain; charset=utf-8";
+	string body;
+};
+
+/// Modification time and size of an input file, a page is up to date if they haven't changed.
+struct input_stamp
+{
+	int64_t mtime = 0;
+	uint64_t size = 0;
+	bool operator==( const input_stamp& o ) const { return mtime == o.mtime && size == o.size; }
+};
+
+class preview_server
+{
+public:
+	preview_server( const xo::path& input_dir, size_t cache_bytes, const dokugen_settings& cfg ) :
+		input_dir_( input_dir ), cache_bytes_( cache_bytes ), cfg_( cfg ), interner_( std::make_shared< string_interner >() ) {}
+
+	void serve( int port, int num_threads )
+	{
+		listen_fd_ = ::socket( AF_INET, SOCK_STREAM, 0 );
+		xo_error_if( listen_fd_ < 0, "Could not create socket" );
+		int reuse = 1;
+		::setsockopt( listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) );
+
+		// only accept connections from this machine
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons( uint16_t( port ) );
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+		if ( ::bind( listen_fd_, reinterpret_cast< sockaddr* >( &addr ), sizeof( addr ) ) != 0 || ::listen( listen_fd_, 64 ) != 0 )
+		{
+			::close( listen_fd_ );
+			xo_error( "Could not listen on port " + std::to_string( port ) );
+		}
+		log::info( "Serving previews of ", input_dir_.str(), " on http://127.0.0.1:", port, "/" );
+
+		// each thread accepts and handles its own connections
+		std::vector< std::thread > threads;
+		for ( int i = 0; i < num_threads; ++i )
+			threads.emplace_back( [this]() {
+				for ( ;; )
+				{
+					int fd = ::accept( listen_fd_, nullptr, nullptr );
+					if ( fd < 0 )
+					{
+						if ( errno == EINTR )
+							continue;
+						break;
+					}
+					handle_connection( fd );
+					::close( fd );
+				}
+			} );
+		for ( auto& t : threads )
+			t.join();
+		::close( listen_fd_ );
+	}
+
+private:
+	struct cache_entry
+	{
+		string key;
+		input_stamp stamp;
+		uint64_t hash;
+		string page;
+	};
+
+	void handle_connection( int fd )
+	{
+		socket_lines lines( fd );
+		string request_line, header;
+		if ( !lines.next( request_line ) )
+			return;
+		while ( lines.next( header ) && !header.empty() ) {}
+
+		// request line is: method target version
+		auto method_end = request_line.find( ' ' );
+		auto target_end = request_line.find( ' ', method_end + 1 );
+		auto method = request_line.substr( 0, method_end );
+		auto target = method_end != string::npos ? request_line.substr( method_end + 1, target_end - method_end - 1 ) : string();
+		target = target.substr( 0, target.find( '?' ) );
+
+		http_response response;
+		if ( method != "GET" && method != "HEAD" )
+			response = { 405, "text/plain; charset=utf-8", "Method not allowed\n" };
+		else if ( target == "/" )
+			response = index_page();
+		else response = page( target.substr( 1 ) );
+
+		string head = "HTTP/1.1 " + std::to_string( response.status ) + ' ' + status_text( response.status ) + "\r\n"
+			+ "Content-Type: " + response.content_type + "\r\n"
+			+ "Content-Length: " + std::to_string( response.body.size() ) + "\r\n"
+			+ "Cache-Control: no-store\r\nConnection: close\r\n\r\n";
+		if ( send_all( fd, head ) && method != "HEAD" )
+			send_all( fd, response.body );
+	}
+
+	static const char* status_text( int status )
+	{
+		switch ( status )
+		{
+		case 200: return "OK";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		default: return "Internal Server Error";
+		}
+	}
+
+	http_response index_page()
+	{
+		http_response r;
+		r.content_type = "text/html; charset=utf-8";
+		r.body = "<html><body><h1>dokugen preview</h1><ul>\n";
+		for ( auto& f : find_input_files( input_dir_ ) )
+		{
+			auto name = f.filename().str();
+			name = name.substr( 0, name.rfind( '.' ) );
+			r.body += "<li>";
+			html_emitter::text( r.body, name );
+			for ( auto& o : cfg_.outputs )
+			{
+				auto page = name + '.' + format_extension( o.format );
+				r.body += " <a href=\"" + page + "\">" + format_extension( o.format ) + "</a>";
+			}
+			r.body += "</li>\n";
+		}
+		r.body += "</ul></body></html>\n";
+		return r;
+	}
+
+	http_response page( const string& page_name )
+	{
+		// pages are named <compound>.<extension>, with the compound name as in the input or in links
+		auto dot = page_name.rfind( '.' );
+		if ( dot == string::npos || page_name.find_first_of( "/\\" ) != string::npos || page_name[ 0 ] == '.' )
+			return not_found( page_name );
+		auto name = page_name.substr( 0, dot );
+		auto ext = page_name.substr( dot + 1 );
+		auto output = std::find_if( cfg_.outputs.begin(), cfg_.outputs.end(),
+			[&]( const output_settings& o ) { return ext == format_extension( o.format ); } );
+		if ( output == cfg_.outputs.end() )
+			return not_found( page_name );
+
+		auto input = input_file( name );
+		std::error_code ec;
+		auto filename = input.str();
+		input_stamp stamp{ int64_t( std::filesystem::last_write_time( filename, ec ).time_since_epoch().count() ),
+			uint64_t( std::filesystem::file_size( filename, ec ) ) };
+		if ( ec )
+			return not_found( page_name );
+
+		http_response r;
+		if ( output->format == output_format::html )
+			r.content_type = "text/html; charset=utf-8";
+		auto key = input.str() + '|' + ext;
+		if ( find_page( key, stamp, nullptr, r.body ) )
+			return r;
+
+		// the file has changed, or has only been touched
+		std::ifstream str( filename, std::ios::binary );
+		string contents( std::istreambuf_iterator< char >( str ), {} );
+		auto hash = model_cache_key( contents );
+		if ( find_page( key, stamp, &hash, r.body ) )
+			return r;
+
+		// render through the same path as a conversion, into memory
+		auto page_cfg = cfg_;
+		page_cfg.outputs = { *output };
+		auto sink = std::make_shared< memory_sink >();
+		page_cfg.sink = sink;
+		page_cfg.interner = interner();
+		auto result = write_doku( input, contents, page_cfg );
+		renew_interner( page_cfg.interner );
+		if ( !result )
+			return { 500, "text/plain; charset=utf-8", result.failure().message + '\n' };
+		auto pages = sink->pages();
+		if ( pages.empty() )
+			return { 404, "text/plain; charset=utf-8", name + " has no brief description and no page\n" };
+
+		r.body = std::move( pages.front().second );
+		add_page( key, stamp, hash, r.body );
+		return r;
+	}
+
+	http_response not_found( const string& page_name ) {
+		return { 404, "text/plain; charset=utf-8", "No page " + page_name + '\n' };
+	}
+
+	std::shared_ptr< string_interner > interner()
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		return interner_;
+	}
+
+	/// Replace the interner used by a render once its fragments take more than the cache size. Cached pages hold copies
+	/// of the fragments, so the old interner is released when the renders that still use it are done.
+	void renew_interner( const std::shared_ptr< string_interner >& used )
+	{
+		if ( used->stats().bytes <= cache_bytes_ )
+			return;
+		std::lock_guard< std::mutex > lock( mutex_ );
+		if ( interner_ == used )
+			interner_ = std::make_shared< string_interner >();
+	}
+
+	/// Input file of a compound, by its name in the input folder or by the name used in links.
+	xo::path input_file( const string& name )
+	{
+		auto direct = input_dir_ / path( name + ".xml" );
+		if ( std::filesystem::exists( direct.str() ) )
+			return direct;
+
+		std::lock_guard< std::mutex > lock( mutex_ );
+		auto it = link_names_.find( name );
+		if ( it == link_names_.end() )
+		{
+			// the compound may be new, refresh the names
+			link_names_.clear();
+			for ( auto& f : find_input_files( input_dir_ ) )
+			{
+				auto stem = f.filename().str();
+				stem = stem.substr( 0, stem.rfind( '.' ) );
+				link_names_.emplace( fix_string( stem, cfg_ ), f );
+			}
+			it = link_names_.find( name );
+		}
+		return it != link_names_.end() ? it->second : direct;
+	}
+
+	/// Get a cached page that is up to date with stamp, or with hash if it is set.
+	bool find_page( const string& key, const input_stamp& stamp, const uint64_t* hash, string& page )
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		auto it = index_.find( key );
+		if ( it == index_.end() )
+			return false;
+		auto& e = *it->second;
+		if ( !( e.stamp == stamp ) && !( hash && e.hash == *hash ) )
+			return false;
+		e.stamp = stamp;
+		entries_.splice( entries_.begin(), entries_, it->second );
+		page = e.page;
+		return true;
+	}
+
+	void add_page( const string& key, const input_stamp& stamp, uint64_t hash, const string& page )
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		if ( auto it = index_.find( key ); it != index_.end() )
+		{
+			cache_size_ -= it->second->page.size();
+			entries_.erase( it->second );
+			index_.erase( it );
+		}
+		entries_.push_front( cache_entry{ key, stamp, hash, page } );
+		index_[ key ] = entries_.begin();
+		cache_size_ += page.size();
+
+		// evict the least recently used pages, but keep the newest
+		while ( cache_size_ > cache_bytes_ && entries_.size() > 1 )
+		{
+			cache_size_ -= entries_.back().page.size();
+			index_.erase( entries_.back().key );
+			entries_.pop_back();
+		}
+	}
+
+	xo::path input_dir_;
+	size_t cache_bytes_;
+	const dokugen_settings& cfg_;
+	int listen_fd_ = -1;
+
+	std::mutex mutex_;
+	std::list< cache_entry > entries_; // most recently used first
+	std::unordered_map< string, std::list< cache_entry >::iterator > index_;
+	size_t cache_size_ = 0;
+	std::unordered_map< string, xo::path > link_names_;
+	std::shared_ptr< string_interner > interner_; // rendered fragments, shared by renders until it grows past the cache size
+};
+
+void serve_preview( const xo::path& input_dir, int port, size_t cache_bytes, const dokugen_settings& cfg, const conversion_settings& run )
+{
+	auto num_threads = run.num_threads > 0 ? run.num_threads : int( std::thread::hardware_concurrency() );
+	preview_server server( input_dir, cache_bytes, cfg );
+	server.serve( port, std::max( num_threads, 1 ) );
+}
+
+#else
+
+void serve_preview( const xo::path& input_dir, int port, size_t cache_bytes, const dokugen_settings& cfg, const conversion_settings& run )
+{
+	xo_error( "The preview server is not supported on this platform" );
+}
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "conversion.h"
+
+/// Serve pages over HTTP on localhost, rendered on request from the class and struct XML files in input_dir.
+/// Pages are requested as /<compound>.<extension> for each output format in cfg, the root lists all compounds.
+/// Rendered pages are kept in an LRU cache of at most cache_bytes; a page is rendered again when its input changes.
+/// Fragments shared between renders are kept in an interner that is replaced once it holds more than cache_bytes.
+void serve_preview( const xo::path& input_dir, int port, size_t cache_bytes, const dokugen_settings& cfg, const conversion_settings& run );
@@ -0,0 +1,41 @@
+#include "remove_matcher.h"
+
+#include <algorithm>
+
+remove_matcher::remove_matcher( const std::vector< std::string >& remove_strings )
+{
+	for ( auto& s : remove_strings )
+	{
+		if ( s.empty() )
+			continue;
+		strings_.push_back( s );
+		first_chars_[ static_cast<unsigned char>( s[ 0 ] ) ] = true;
+	}
+}
+
+void remove_matcher::apply( std::string& str ) const
+{
+	if ( std::none_of( str.begin(), str.end(), [&]( char c ) { return first_chars_[ static_cast<unsigned char>( c ) ]; } ) )
+		return;
+
+	for ( auto& s : strings_ )
+	{
+		auto match = str.find( s );
+		if ( match == std::string::npos )
+			continue;
+
+		// move the text between matches over the removed parts; the text after the write position is still unchanged,
+		// so searching on from the read position finds what a search in the shortened string would find
+		auto write = match;
+		for ( auto read = match + s.size(); ; read = match + s.size() )
+		{
+			match = str.find( s, read );
+			auto end = match != std::string::npos ? match : str.size();
+			std::copy( str.begin() + read, str.begin() + end, str.begin() + write );
+			write += end - read;
+			if ( match == std::string::npos )
+				break;
+		}
+		str.resize( write );
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+/// Remove strings, compiled once per run so names can be fixed without searching for each remove string.
+/// Names without any first character of the remove strings are skipped in a single scan;
+/// matches are removed in place, in one pass per remove string.
+class remove_matcher
+{
+public:
+	remove_matcher() = default;
+	explicit remove_matcher( const std::vector< std::string >& remove_strings );
+
+	/// Remove all occurrences of each remove string in turn, with the same result as xo::replace_str( str, s, "" ).
+	void apply( std::string& str ) const;
+
+private:
+	std::vector< std::string > strings_;
+	std::array< bool, 256 > first_chars_{};
+};
@@ -0,0 +1,84 @@
+#include "result_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "xo/system/log.h"
+
+using namespace xo;
+
+result_log::result_log( size_t num_workers, bool quiet, bool sort_by_input ) :
+	quiet_( quiet ),
+	sort_by_input_( sort_by_input ),
+	total_( std::numeric_limits< size_t >::max() )
+{
+	for ( size_t i = 0; i < num_workers; ++i )
+		queues_.emplace_back( std::make_unique< spsc_queue< posted_result > >() );
+	thread_ = std::thread( &result_log::run, this );
+}
+
+result_log::~result_log()
+{
+	finish( 0 );
+}
+
+void result_log::post( size_t worker, size_t index, const conversion_result* result )
+{
+	// the log thread keeps up easily, a full queue is very rare
+	while ( !queues_[ worker ]->try_push( posted_result{ index, result } ) )
+		std::this_thread::yield();
+}
+
+void result_log::finish( size_t total )
+{
+	if ( thread_.joinable() )
+	{
+		total_ = total;
+		thread_.join();
+	}
+}
+
+void result_log::run()
+{
+	// the number of results is only known once the input is exhausted
+	std::vector< const conversion_result* > done;
+	size_t next_log = 0;
+	while ( next_log < total_ )
+	{
+		bool received = false;
+		for ( auto& q : queues_ )
+		{
+			for ( posted_result p; q->try_pop( p ); received = true )
+			{
+				if ( p.index >= done.size() )
+					done.resize( p.index + 1 );
+				done[ p.index ] = p.result;
+			}
+		}
+
+		// results finish out of order, log only the completed head of the table
+		while ( next_log < done.size() && done[ next_log ] )
+			if ( !sort_by_input_ )
+				log_result( *done[ next_log++ ] );
+			else ++next_log;
+
+		if ( !received )
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	}
+
+	if ( sort_by_input_ )
+	{
+		done.resize( next_log );
+		std::sort( done.begin(), done.end(), []( const conversion_result* a, const conversion_result* b ) { return a->input.str() < b->input.str(); } );
+		for ( auto* r : done )
+			log_result( *r );
+	}
+}
+
+void result_log::log_result( const conversion_result& r )
+{
+	if ( !r.converted )
+		log::error( r.input.str(), ": ", r.error );
+	else if ( !quiet_ )
+		log::info( r.input.str(), ": ", r.elements, " elements converted" );
+}
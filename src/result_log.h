@@ -0,0 +1,35 @@
+#pragma once
+
+#include "conversion.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/// Logs conversion results from a background thread, in input order, while the workers continue.
+/// Each worker posts finished results to its own lock-free queue; only the log thread touches the console.
+/// If the input order is not reproducible, sort_by_input can be set to log all results sorted by input path at the end.
+class result_log
+{
+public:
+	result_log( size_t num_workers, bool quiet, bool sort_by_input = false );
+	~result_log();
+
+	/// Called by a worker after it has finished result number index.
+	void post( size_t worker, size_t index, const conversion_result* result );
+
+	/// Wait until all results have been logged, total is the number of results.
+	void finish( size_t total );
+
+private:
+	struct posted_result { size_t index; const conversion_result* result; };
+
+	void run();
+	void log_result( const conversion_result& r );
+
+	std::vector< std::unique_ptr< spsc_queue< posted_result > > > queues_;
+	bool quiet_;
+	bool sort_by_input_;
+	std::atomic< size_t > total_;
+	std::thread thread_;
+};
@@ -0,0 +1,238 @@
+#include "server.h"
+#include "socket_io.h"
+
+#include "xo/system/log.h"
+#include "xo/system/assert.h"
+#include "xo/filesystem/filesystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <map>
+#include <set>
+
+#ifndef _WIN32
+#	include <sys/socket.h>
+#	include <sys/un.h>
+#	include <unistd.h>
+#endif
+
+using namespace xo;
+using std::string;
+
+#ifndef _WIN32
+
+struct conversion_request
+{
+	std::vector< xo::path > input_dirs;
+	std::vector< xo::path > files;
+	xo::path output_dir;
+	std::vector< string > remove_strings;
+	string error;
+};
+
+class conversion_server
+{
+public:
+	conversion_server( const dokugen_settings& defaults, const conversion_settings& run ) :
+		defaults_( defaults ), run_( run ), pool_( run ) {}
+
+	void serve( const string& socket_path )
+	{
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		xo_error_if( socket_path.size() >= sizeof( addr.sun_path ), "Socket path is too long: " + socket_path );
+		socket_path.copy( addr.sun_path, socket_path.size() );
+
+		// a socket file left by a previous server would make bind fail
+		::unlink( socket_path.c_str() );
+		listen_fd_ = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+		xo_error_if( listen_fd_ < 0, "Could not create socket" );
+		if ( ::bind( listen_fd_, reinterpret_cast< sockaddr* >( &addr ), sizeof( addr ) ) != 0 || ::listen( listen_fd_, 16 ) != 0 )
+		{
+			::close( listen_fd_ );
+			xo_error( "Could not listen on " + socket_path );
+		}
+		log::info( "Serving conversion requests on ", socket_path );
+
+		while ( !stopping_ )
+		{
+			int fd = ::accept( listen_fd_, nullptr, nullptr );
+			if ( fd < 0 )
+			{
+				if ( errno == EINTR && !stopping_ )
+					continue;
+				break;
+			}
+			std::lock_guard< std::mutex > lock( mutex_ );
+			clients_.insert( fd );
+			std::thread( &conversion_server::handle_client, this, fd ).detach();
+		}
+
+		// wait for the clients that are still connected
+		std::unique_lock< std::mutex > lock( mutex_ );
+		for ( int fd : clients_ )
+			::shutdown( fd, SHUT_RDWR );
+		clients_done_.wait( lock, [&]() { return clients_.empty(); } );
+		::close( listen_fd_ );
+		::unlink( socket_path.c_str() );
+		log::info( "Server stopped" );
+	}
+
+private:
+	void handle_client( int fd )
+	{
+		socket_lines lines( fd );
+		conversion_request req;
+		bool has_request = false;
+		for ( string line; lines.next( line ); )
+		{
+			if ( line.empty() )
+			{
+				if ( has_request && !send_all( fd, handle_request( req ) ) )
+					break;
+				req = conversion_request();
+				has_request = false;
+				continue;
+			}
+
+			has_request = true;
+			auto space = line.find( ' ' );
+			auto key = line.substr( 0, space );
+			auto value = space != string::npos ? line.substr( space + 1 ) : string();
+			if ( key == "input" )
+				req.input_dirs.emplace_back( value );
+			else if ( key == "file" )
+				req.files.emplace_back( value );
+			else if ( key == "output" )
+				req.output_dir = path( value );
+			else if ( key == "remove" )
+				req.remove_strings.emplace_back( value );
+			else if ( key == "shutdown" )
+			{
+				stop( fd );
+				break;
+			}
+			else if ( req.error.empty() )
+				req.error = "Unknown request line: " + line;
+		}
+
+		// the fd is closed last, so its number cannot be reused by a new client while it's still in clients_,
+		// and this thread doesn't touch the server once serve() has seen it leave
+		{
+			std::lock_guard< std::mutex > lock( mutex_ );
+			clients_.erase( fd );
+			clients_done_.notify_all();
+		}
+		::close( fd );
+	}
+
+	string handle_request( conversion_request& req )
+	{
+		try
+		{
+			xo_error_if( !req.error.empty(), req.error );
+			xo_error_if( req.output_dir.empty(), "Missing output folder" );
+			for ( auto& dir : req.input_dirs )
+			{
+				auto files = find_input_files( dir );
+				req.files.insert( req.files.end(), files.begin(), files.end() );
+			}
+
+			// fragments depend on the remove strings, so requests with the same remove strings share an interner
+			auto cfg = defaults_;
+			cfg.output_dir = req.output_dir;
+			auto context = remove_context_for( req.remove_strings );
+			cfg.remove_strings = context.matcher;
+			cfg.interner = context.interner;
+			xo::create_directories( cfg.output_dir );
+
+			auto results = pool_.convert( req.files, cfg );
+			auto summary = summarize( results );
+			string response;
+			for ( auto& r : results )
+				if ( !r.converted )
+					response += "error " + r.input.str() + '\t' + r.error + '\n';
+			response += "done " + std::to_string( summary.converted ) + ' ' + std::to_string( summary.failed ) + ' '
+				+ std::to_string( summary.elements ) + '\n';
+			if ( !run_.quiet )
+				log::info( "Converted ", summary.converted, " files to ", cfg.output_dir.str(), " (", summary.failed, " failed)" );
+			return response;
+		}
+		catch ( std::exception& e )
+		{
+			log::error( e.what() );
+			return string( "failed " ) + e.what() + '\n';
+		}
+	}
+
+	// compiled remove strings and the interner of the fragments rendered with them
+	struct remove_context
+	{
+		std::shared_ptr< const remove_matcher > matcher;
+		std::shared_ptr< string_interner > interner;
+		uint64_t last_used = 0;
+	};
+
+	// contexts are kept for the most recently used remove strings only, since each interner keeps its fragments
+	static const size_t max_remove_contexts = 16;
+
+	remove_context remove_context_for( const std::vector< string >& remove_strings )
+	{
+		string key;
+		for ( auto& s : remove_strings )
+			key += s + '\n';
+		std::lock_guard< std::mutex > lock( mutex_ );
+		auto& context = remove_contexts_[ key ];
+		if ( !context.matcher )
+		{
+			context.matcher = std::make_shared< remove_matcher >( remove_strings );
+			context.interner = std::make_shared< string_interner >();
+		}
+		context.last_used = ++remove_context_uses_;
+		if ( remove_contexts_.size() > max_remove_contexts )
+		{
+			// requests that still use an evicted context keep it alive through their settings
+			auto oldest = std::min_element( remove_contexts_.begin(), remove_contexts_.end(),
+				[]( auto& a, auto& b ) { return a.second.last_used < b.second.last_used; } );
+			remove_contexts_.erase( oldest );
+		}
+		return context;
+	}
+
+	void stop( int requesting_fd )
+	{
+		std::lock_guard< std::mutex > lock( mutex_ );
+		stopping_ = true;
+		::shutdown( listen_fd_, SHUT_RDWR );
+		for ( int fd : clients_ )
+			if ( fd != requesting_fd )
+				::shutdown( fd, SHUT_RDWR );
+	}
+
+	const dokugen_settings& defaults_;
+	const conversion_settings& run_;
+	conversion_pool pool_;
+	int listen_fd_ = -1;
+	std::atomic< bool > stopping_{ false };
+	std::mutex mutex_;
+	std::condition_variable clients_done_;
+	std::set< int > clients_;
+	std::map< string, remove_context > remove_contexts_;
+	uint64_t remove_context_uses_ = 0;
+};
+
+void serve_conversions( const std::string& socket_path, const dokugen_settings& defaults, const conversion_settings& run )
+{
+	conversion_server server( defaults, run );
+	server.serve( socket_path );
+}
+
+#else
+
+void serve_conversions( const std::string& socket_path, const dokugen_settings& defaults, const conversion_settings& run )
+{
+	xo_error( "Serving conversion requests is not supported on this platform" );
+}
+
+#endif
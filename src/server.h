@@ -0,0 +1,15 @@
+#pragma once
+
+#include "conversion.h"
+#include <string>
+
+/// Serve batch conversion requests on a Unix domain socket until a client sends shutdown.
+/// A request is a list of lines, terminated by an empty line:
+///   input <folder>     convert the class and struct XML files in folder
+///   file <path>        convert a single XML file (can be repeated)
+///   output <folder>    folder where to write the pages
+///   remove <string>    remove part of names (can be repeated)
+/// The server answers with a line per failed file, "error <path>\t<message>",
+/// followed by "done <converted> <failed> <elements>", or with "failed <message>" if the request is invalid.
+/// Output formats, layouts and the cache folder are taken from defaults.
+void serve_conversions( const std::string& socket_path, const dokugen_settings& defaults, const conversion_settings& run );
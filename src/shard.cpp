@@ -0,0 +1,265 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "xo/system/log.h"
+#include "xo/string/string_tools.h"
+
+using namespace xo;
+using std::string;
+
+const char* manifest_header = "dokugen-manifest 1";
+
+shard_spec parse_shard_spec( const std::string& str, bool by_size )
+{
+	shard_spec s;
+	s.by_size = by_size;
+	char slash = 0;
+	std::istringstream is( str );
+	is >> s.index >> slash >> s.count;
+	xo_error_if( is.fail() || slash != '/' || !is.eof() || s.count < 1 || s.count > shard_spec::max_count || s.index < 0 || s.index >= s.count,
+		"Invalid shard: " + str + ", expected i/N with 0 <= i < N <= " + std::to_string( shard_spec::max_count ) );
+	return s;
+}
+
+uint64_t stable_hash( const string& str )
+{
+	// FNV-1a, std::hash is not guaranteed to be the same across machines
+	uint64_t h = 14695981039346656037ull;
+	for ( unsigned char c : str )
+		h = ( h ^ c ) * 1099511628211ull;
+	return h;
+}
+
+bool in_shard( const xo::path& file, const shard_spec& shard )
+{
+	return stable_hash( file.filename().str() ) % shard.count == uint64_t( shard.index );
+}
+
+std::vector< xo::path > select_shard( const std::vector< xo::path >& files, const shard_spec& shard )
+{
+	std::vector< xo::path > selection;
+	if ( !shard.by_size )
+	{
+		for ( auto& f : files )
+			if ( in_shard( f, shard ) )
+				selection.push_back( f );
+		return selection;
+	}
+
+	// assign largest files first, each to the shard with the least bytes so far
+	struct sized_file { uintmax_t size; string name; size_t idx; };
+	std::vector< sized_file > sized;
+	for ( size_t i = 0; i < files.size(); ++i )
+	{
+		std::error_code ec;
+		auto size = std::filesystem::file_size( files[ i ].str(), ec );
+		sized.push_back( { ec ? 0 : size, files[ i ].filename().str(), i } );
+	}
+	std::sort( sized.begin(), sized.end(), []( const sized_file& a, const sized_file& b ) {
+		return a.size != b.size ? a.size > b.size : a.name < b.name;
+	} );
+
+	std::vector< uintmax_t > load( shard.count );
+	std::vector< size_t > selected_idx;
+	for ( auto& f : sized )
+	{
+		auto target = std::min_element( load.begin(), load.end() ) - load.begin();
+		load[ target ] += std::max< uintmax_t >( f.size, 1 );
+		if ( target == shard.index )
+			selected_idx.push_back( f.idx );
+	}
+
+	// keep the original (sorted) input order
+	std::sort( selected_idx.begin(), selected_idx.end() );
+	for ( auto i : selected_idx )
+		selection.push_back( files[ i ] );
+	return selection;
+}
+
+string manifest_field( string str )
+{
+	std::replace_if( str.begin(), str.end(), []( char c ) { return c == '\t' || c == '\n' || c == '\r'; }, ' ' );
+	return str;
+}
+
+xo::path write_shard_manifest( const xo::path& output_dir, const shard_spec& shard,
+	const std::vector< conversion_result >& results, double duration )
+{
+	auto s = summarize( results );
+	auto filename = output_dir / path( "dokugen-shard-" + std::to_string( shard.index ) + "-of-" + std::to_string( shard.count ) + ".manifest" );
+	std::ofstream str( filename.str() );
+	xo_error_if( !str.good(), "Could not write " + filename.str() );
+
+	str << manifest_header << '\n';
+	str << "shard\t" << shard.index << '\t' << shard.count << '\n';
+	str << "stats\t" << results.size() << '\t' << s.converted << '\t' << s.failed << '\t' << s.elements << '\t' << duration << '\n';
+	for ( auto& r : results )
+		str << "file\t" << manifest_field( r.input.filename().str() ) << '\t' << r.elements << '\t'
+		<< ( r.converted ? "ok" : "failed" ) << '\t' << manifest_field( r.error ) << '\n';
+
+	return filename;
+}
+
+std::vector< xo::path > find_shard_manifests( const xo::path& folder )
+{
+	std::vector< xo::path > manifests;
+	for ( auto& e : std::filesystem::directory_iterator( folder.str() ) )
+	{
+		auto p = xo::path( e.path().string() );
+		if ( str_begins_with( p.filename().str(), "dokugen-shard-" ) && p.extension_no_dot() == "manifest" )
+			manifests.push_back( p );
+	}
+	std::sort( manifests.begin(), manifests.end(), []( const xo::path& a, const xo::path& b ) { return a.str() < b.str(); } );
+	return manifests;
+}
+
+struct shard_report
+{
+	int index = 0;
+	int count = 0;
+	size_t files = 0;
+	conversion_summary summary;
+	double duration = 0;
+	std::vector< std::pair< string, string > > failures;
+	xo::path file;
+};
+
+shard_report read_shard_manifest( const xo::path& filename )
+{
+	std::ifstream str( filename.str() );
+	xo_error_if( !str.good(), "Could not open " + filename.str() );
+
+	shard_report rep;
+	string line;
+	std::getline( str, line );
+	xo_error_if( line != manifest_header, filename.str() + " is not a dokugen shard manifest" );
+	try
+	{
+		while ( std::getline( str, line ) )
+		{
+			std::vector< string > fields;
+			std::istringstream ls( line );
+			for ( string f; std::getline( ls, f, '\t' ); )
+				fields.push_back( f );
+			if ( fields.empty() )
+				continue;
+
+			if ( fields[ 0 ] == "shard" && fields.size() >= 3 )
+			{
+				rep.index = std::stoi( fields[ 1 ] );
+				rep.count = std::stoi( fields[ 2 ] );
+			}
+			else if ( fields[ 0 ] == "stats" && fields.size() >= 6 )
+			{
+				rep.files = std::stoul( fields[ 1 ] );
+				rep.summary.converted = std::stoi( fields[ 2 ] );
+				rep.summary.failed = std::stoi( fields[ 3 ] );
+				rep.summary.elements = std::stoi( fields[ 4 ] );
+				rep.duration = std::stod( fields[ 5 ] );
+			}
+			else if ( fields[ 0 ] == "file" && fields.size() >= 4 && fields[ 3 ] != "ok" )
+				rep.failures.emplace_back( fields[ 1 ], fields.size() >= 5 ? fields[ 4 ] : "" );
+		}
+	}
+	catch ( std::logic_error& ) // std::invalid_argument or std::out_of_range from a number field
+	{
+		xo_error( "Invalid manifest " + filename.str() + ": " + line );
+	}
+	xo_error_if( rep.count < 1 || rep.count > shard_spec::max_count || rep.index < 0 || rep.index >= rep.count,
+		"Invalid manifest " + filename.str() + ": no valid shard" );
+	return rep;
+}
+
+merged_shards merge_shard_manifests( const std::vector< xo::path >& manifests, const xo::path& report_file )
+{
+	std::vector< shard_report > shards;
+	for ( auto& m : manifests )
+	{
+		shards.push_back( read_shard_manifest( m ) );
+		shards.back().file = m;
+	}
+	std::sort( shards.begin(), shards.end(), []( const shard_report& a, const shard_report& b ) { return a.index < b.index; } );
+
+	// manifests are grouped by their number of shards; the merge is complete with a single run that has all its shards
+	std::map< int, std::vector< const shard_report* > > runs;
+	for ( auto& s : shards )
+		runs[ s.count ].push_back( &s );
+
+	std::ostringstream report;
+	merged_shards result;
+	result.complete = runs.size() == 1;
+	if ( runs.empty() )
+		report << "No shard manifests found\n";
+	if ( runs.size() > 1 )
+	{
+		report << "Manifests of " << runs.size() << " runs found:";
+		for ( auto& [ count, run ] : runs )
+			report << " " << run.size() << " of " << count << " shards;";
+		report << " remove the manifests of the outdated runs\n";
+	}
+
+	size_t total_files = 0;
+	double max_duration = 0;
+	std::vector< std::pair< string, string > > failures;
+	for ( auto& [ count, run ] : runs )
+	{
+		std::vector< bool > present( count );
+		for ( auto* s : run )
+		{
+			if ( present[ s->index ] )
+			{
+				report << "Shard " << s->index << "/" << count << " is a duplicate: " << s->file.filename().str() << "\n";
+				result.complete = false;
+				continue;
+			}
+			present[ s->index ] = true;
+			report << "Shard " << s->index << "/" << count << ": " << s->files << " files, " << s->summary.converted << " converted, "
+				<< s->summary.failed << " failed, " << s->summary.elements << " elements, " << s->duration << "s\n";
+			result.summary.converted += s->summary.converted;
+			result.summary.failed += s->summary.failed;
+			result.summary.elements += s->summary.elements;
+			total_files += s->files;
+			max_duration = std::max( max_duration, s->duration );
+			failures.insert( failures.end(), s->failures.begin(), s->failures.end() );
+		}
+		for ( int i = 0; i < count; ++i )
+			if ( !present[ i ] )
+			{
+				report << "Shard " << i << "/" << count << " is missing\n";
+				result.complete = false;
+			}
+	}
+
+	auto& total = result.summary;
+	report << "Total: " << total_files << " files, " << total.converted << " converted, " << total.failed << " failed, "
+		<< total.elements << " elements, slowest shard " << max_duration << "s\n";
+	std::sort( failures.begin(), failures.end() );
+	for ( auto& f : failures )
+		report << "Failed: " << f.first << ": " << f.second << "\n";
+
+	std::istringstream lines( report.str() );
+	for ( string line; std::getline( lines, line ); )
+		log::info( line );
+
+	if ( !report_file.empty() )
+	{
+		std::ofstream str( report_file.str() );
+		xo_error_if( !str.good(), "Could not write " + report_file.str() );
+		str << report.str();
+	}
+
+	// the manifests are in the output folder of the shards, which is published with the pages
+	if ( result.complete )
+	{
+		for ( auto& s : shards )
+			std::filesystem::remove( s.file.str() );
+		log::info( "Removed ", shards.size(), " shard manifests" );
+	}
+
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "conversion.h"
+
+/// Selects part i of N of the input files, so a conversion can be split across processes or machines.
+struct shard_spec
+{
+	static constexpr int max_count = 10000;
+
+	int index = 0;
+	int count = 0; // zero when the input is not sharded
+	bool by_size = false; // balance shards by file size instead of filename hash
+
+	bool enabled() const { return count > 0; }
+	std::string name() const { return std::to_string( index ) + "/" + std::to_string( count ); }
+};
+
+/// Parse a shard spec from "i/N", with 0 <= i < N <= max_count; throws on invalid input.
+shard_spec parse_shard_spec( const std::string& str, bool by_size );
+
+/// Check if a file belongs to a shard that is not balanced by size.
+bool in_shard( const xo::path& file, const shard_spec& shard );
+
+/// Get the files of a shard. The result only depends on the filenames (and sizes if by_size is set),
+/// so all shards agree on the partition, even when their input folders are in different locations.
+std::vector< xo::path > select_shard( const std::vector< xo::path >& files, const shard_spec& shard );
+
+/// Write the results and statistics of a shard to a manifest in output_dir, returns the manifest filename.
+xo::path write_shard_manifest( const xo::path& output_dir, const shard_spec& shard,
+	const std::vector< conversion_result >& results, double duration );
+
+/// Find all shard manifests in a folder, sorted by filename.
+std::vector< xo::path > find_shard_manifests( const xo::path& folder );
+
+/// Combined results of the shards of a run.
+struct merged_shards
+{
+	conversion_summary summary;
+	bool complete = false; // all shards of a single run were found, without duplicates
+};
+
+/// Combine shard manifests into one run report, which is logged and written to report_file (if not empty).
+/// Manifests are grouped by shard count; after a complete merge, the manifests are removed.
+/// Throws if a manifest cannot be read.
+merged_shards merge_shard_manifests( const std::vector< xo::path >& manifests, const xo::path& report_file );
@@ -0,0 +1,49 @@
+#include "socket_io.h"
+
+#ifndef _WIN32
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+const int socket_send_flags = MSG_NOSIGNAL; // a client that hangs up must not kill the server
+#else
+const int socket_send_flags = 0;
+#endif
+
+bool socket_lines::next( std::string& line )
+{
+	for ( ;; )
+	{
+		auto eol = buf_.find( '\n', pos_ );
+		if ( eol != std::string::npos )
+		{
+			line.assign( buf_, pos_, eol - pos_ );
+			if ( !line.empty() && line.back() == '\r' )
+				line.pop_back();
+			pos_ = eol + 1;
+			return true;
+		}
+		buf_.erase( 0, pos_ );
+		pos_ = 0;
+		char data[ 4096 ];
+		auto n = ::recv( fd_, data, sizeof( data ), 0 );
+		if ( n <= 0 )
+			return false;
+		buf_.append( data, size_t( n ) );
+	}
+}
+
+bool send_all( int fd, std::string_view s )
+{
+	while ( !s.empty() )
+	{
+		auto n = ::send( fd, s.data(), s.size(), socket_send_flags );
+		if ( n <= 0 )
+			return false;
+		s.remove_prefix( size_t( n ) );
+	}
+	return true;
+}
+
+#endif
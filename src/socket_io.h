@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Helpers for the POSIX sockets of the server modes.
+
+/// Reads lines from a socket, through a buffer.
+class socket_lines
+{
+public:
+	explicit socket_lines( int fd ) : fd_( fd ) {}
+
+	/// Get the next line without line ending, returns false when the connection is closed.
+	bool next( std::string& line );
+
+private:
+	int fd_;
+	std::string buf_;
+	size_t pos_ = 0;
+};
+
+/// Send all of s, returns false if the connection is closed. Never raises SIGPIPE.
+bool send_all( int fd, std::string_view s );
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+/// Bounded lock-free queue for a single producer and a single consumer thread.
+template< typename T > class spsc_queue
+{
+public:
+	explicit spsc_queue( size_t capacity = 1024 ) : buffer_( capacity + 1 ), head_( 0 ), tail_( 0 ) {}
+	spsc_queue( const spsc_queue& ) = delete;
+	spsc_queue& operator=( const spsc_queue& ) = delete;
+
+	/// Called by the producer, returns false if the queue is full.
+	bool try_push( const T& value ) {
+		auto tail = tail_.load( std::memory_order_relaxed );
+		auto next = increment( tail );
+		if ( next == head_.load( std::memory_order_acquire ) )
+			return false;
+		buffer_[ tail ] = value;
+		tail_.store( next, std::memory_order_release );
+		return true;
+	}
+
+	/// Called by the consumer, returns false if the queue is empty.
+	bool try_pop( T& value ) {
+		auto head = head_.load( std::memory_order_relaxed );
+		if ( head == tail_.load( std::memory_order_acquire ) )
+			return false;
+		value = buffer_[ head ];
+		head_.store( increment( head ), std::memory_order_release );
+		return true;
+	}
+
+private:
+	size_t increment( size_t i ) const { return i + 1 == buffer_.size() ? 0 : i + 1; }
+
+	std::vector< T > buffer_;
+	alignas( 64 ) std::atomic< size_t > head_;
+	alignas( 64 ) std::atomic< size_t > tail_;
+};
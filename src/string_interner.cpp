@@ -0,0 +1,108 @@
+#include "string_interner.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// interned strings never move, so a thread can keep views to them in a cache of its own;
+	// entries are tagged with the generation of the interner they belong to
+	struct local_entry
+	{
+		uint64_t generation = 0;
+		size_t hash = 0;
+		char tag = 0;
+		std::string_view key;
+		std::string_view value;
+	};
+	const size_t local_cache_size = 1024;
+	thread_local std::array< local_entry, local_cache_size > local_cache;
+	std::atomic< uint64_t > next_generation = 1;
+
+	const size_t min_block_size = 64 * 1024;
+}
+
+double string_interner::statistics::hit_rate() const
+{
+	auto lookups = local_hits + shared_hits + misses;
+	return lookups > 0 ? double( local_hits + shared_hits ) / lookups : 0.0;
+}
+
+string_interner::string_interner() :
+	local_hits_( 0 ),
+	generation_( next_generation++ )
+{}
+
+std::string_view string_interner::shard::store( std::string_view s )
+{
+	if ( s.empty() )
+		return std::string_view();
+	if ( block_used + s.size() > block_size )
+	{
+		block_size = std::max( min_block_size, s.size() );
+		blocks.emplace_back( new char[ block_size ] );
+		block_used = 0;
+	}
+	auto p = blocks.back().get() + block_used;
+	memcpy( p, s.data(), s.size() );
+	block_used += s.size();
+	bytes += s.size();
+	return std::string_view( p, s.size() );
+}
+
+bool string_interner::find( size_t h, char tag, std::string_view key, std::string_view& value )
+{
+	auto& le = local_cache[ h % local_cache_size ];
+	if ( le.generation == generation_ && le.hash == h && le.tag == tag && le.key == key )
+	{
+		local_hits_.fetch_add( 1, std::memory_order_relaxed );
+		value = le.value;
+		return true;
+	}
+
+	auto& s = shards_[ h % shard_count ];
+	std::lock_guard< std::mutex > lock( s.mutex );
+	if ( auto it = s.entries.find( entry_key{ tag, key } ); it != s.entries.end() )
+	{
+		++s.shared_hits;
+		le = local_entry{ generation_, h, tag, it->first.str, it->second };
+		value = it->second;
+		return true;
+	}
+	return false;
+}
+
+std::string_view string_interner::insert( size_t h, char tag, std::string_view key, std::string_view value )
+{
+	auto& s = shards_[ h % shard_count ];
+	std::lock_guard< std::mutex > lock( s.mutex );
+
+	// another thread may have added the same entry in the meantime
+	auto it = s.entries.find( entry_key{ tag, key } );
+	if ( it == s.entries.end() )
+	{
+		++s.misses;
+		auto stored_key = s.store( key );
+		auto stored_value = tag == 0 ? stored_key : s.store( value );
+		it = s.entries.emplace( entry_key{ tag, stored_key }, stored_value ).first;
+	}
+	else ++s.shared_hits;
+
+	local_cache[ h % local_cache_size ] = local_entry{ generation_, h, tag, it->first.str, it->second };
+	return it->second;
+}
+
+string_interner::statistics string_interner::stats() const
+{
+	statistics st;
+	st.local_hits = local_hits_.load( std::memory_order_relaxed );
+	for ( auto& s : shards_ )
+	{
+		std::lock_guard< std::mutex > lock( s.mutex );
+		st.shared_hits += s.shared_hits;
+		st.misses += s.misses;
+		st.entries += s.entries.size();
+		st.bytes += s.bytes;
+	}
+	return st;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Thread-safe store of strings that are shared across all compounds of a run.
+/// Each entry maps a (tag, key) pair to a value, both stored once for the lifetime of the interner.
+/// Lookups first check a small thread-local cache, so repeated strings are found without locking;
+/// other lookups lock only one of the shards.
+class string_interner
+{
+public:
+	struct statistics
+	{
+		uint64_t local_hits = 0;
+		uint64_t shared_hits = 0;
+		uint64_t misses = 0;
+		uint64_t entries = 0;
+		uint64_t bytes = 0;
+		double hit_rate() const;
+	};
+
+	string_interner();
+	string_interner( const string_interner& ) = delete;
+	string_interner& operator=( const string_interner& ) = delete;
+
+	/// Get the interned copy of s.
+	std::string_view intern( std::string_view s ) {
+		return find_or_add( 0, s, [&]( std::string& v ) { v = s; } );
+	}
+
+	/// Get the value associated with (tag, key), make_value( std::string& ) creates the value if there is none yet.
+	template< typename F > std::string_view find_or_add( char tag, std::string_view key, F make_value )
+	{
+		auto h = hash( tag, key );
+		std::string_view value;
+		if ( find( h, tag, key, value ) )
+			return value;
+
+		// create the value outside of the lock
+		thread_local std::string buffer;
+		buffer.clear();
+		make_value( buffer );
+		return insert( h, tag, key, buffer );
+	}
+
+	statistics stats() const;
+
+private:
+	struct entry_key
+	{
+		char tag;
+		std::string_view str;
+		bool operator==( const entry_key& o ) const { return tag == o.tag && str == o.str; }
+	};
+	struct entry_hash { size_t operator()( const entry_key& k ) const { return hash( k.tag, k.str ); } };
+
+	struct shard
+	{
+		mutable std::mutex mutex;
+		std::unordered_map< entry_key, std::string_view, entry_hash > entries;
+		std::vector< std::unique_ptr< char[] > > blocks;
+		size_t block_used = 0;
+		size_t block_size = 0;
+		uint64_t shared_hits = 0;
+		uint64_t misses = 0;
+		uint64_t bytes = 0;
+		std::string_view store( std::string_view s );
+	};
+
+	static size_t hash( char tag, std::string_view key ) {
+		return std::hash< std::string_view >()( key ) ^ ( size_t( uint8_t( tag ) ) * 0x9E3779B97F4A7C15ull );
+	}
+	bool find( size_t h, char tag, std::string_view key, std::string_view& value );
+	std::string_view insert( size_t h, char tag, std::string_view key, std::string_view value );
+
+	static const size_t shard_count = 64;
+	std::array< shard, shard_count > shards_;
+	std::atomic< uint64_t > local_hits_;
+	uint64_t generation_;
+};
@@ -0,0 +1,28 @@
+#include "string_pool.h"
+
+#include "xo/system/assert.h"
+
+pool_string string_pool::add( std::string_view s )
+{
+	xo_error_if( external_, "Cannot add strings to an external string pool" );
+
+	auto h = std::hash< std::string_view >()( s );
+	auto range = index_.equal_range( h );
+	for ( auto it = range.first; it != range.second; ++it )
+		if ( ( *this )[ it->second ] == s )
+			return it->second;
+
+	pool_string ps{ uint32_t( storage_.size() ), uint32_t( s.size() ) };
+	storage_.append( s );
+	index_.emplace( h, ps );
+	return ps;
+}
+
+void string_pool::assign_external( std::shared_ptr< const void > owner, const char* data, size_t size )
+{
+	storage_.clear();
+	index_.clear();
+	external_ = std::move( owner );
+	external_data_ = data;
+	external_size_ = size;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// Reference to a string in a string_pool.
+struct pool_string
+{
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+/// Contiguous storage for strings, identical strings are stored only once.
+/// A pool can also refer to external data (e.g. a memory mapped cache entry), which is then kept alive by the pool.
+class string_pool
+{
+public:
+	/// Add a string to the pool, or return the existing reference if the pool already contains it.
+	pool_string add( std::string_view s );
+
+	std::string_view operator[]( pool_string s ) const { return std::string_view( data() + s.offset, s.size ); }
+	const char* data() const { return external_ ? external_data_ : storage_.data(); }
+	size_t size() const { return external_ ? external_size_ : storage_.size(); }
+
+	/// Use external data as pool contents, owner keeps the data alive.
+	void assign_external( std::shared_ptr< const void > owner, const char* data, size_t size );
+
+	void reserve( size_t size ) { storage_.reserve( size ); }
+
+private:
+	std::string storage_;
+	std::unordered_multimap< size_t, pool_string > index_;
+	std::shared_ptr< const void > external_;
+	const char* external_data_ = nullptr;
+	size_t external_size_ = 0;
+};
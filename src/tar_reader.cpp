@@ -0,0 +1,133 @@
+#include "tar_reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "xo/system/assert.h"
+
+const size_t tar_block_size = 512;
+
+uint64_t parse_tar_number( const char* field, size_t size )
+{
+	// GNU base-256 encoding for large values
+	if ( static_cast<unsigned char>( field[ 0 ] ) & 0x80 )
+	{
+		uint64_t value = static_cast<unsigned char>( field[ 0 ] ) & 0x7f;
+		for ( size_t i = 1; i < size; ++i )
+			value = ( value << 8 ) | static_cast<unsigned char>( field[ i ] );
+		return value;
+	}
+
+	uint64_t value = 0;
+	for ( size_t i = 0; i < size && field[ i ]; ++i )
+		if ( field[ i ] >= '0' && field[ i ] <= '7' )
+			value = value * 8 + ( field[ i ] - '0' );
+	return value;
+}
+
+std::string tar_string( const char* field, size_t size ) {
+	return std::string( field, std::find( field, field + size, '\0' ) );
+}
+
+bool valid_checksum( const char* block )
+{
+	unsigned int sum = 0;
+	for ( size_t i = 0; i < tar_block_size; ++i )
+		sum += ( i >= 148 && i < 156 ) ? ' ' : static_cast<unsigned char>( block[ i ] );
+	return sum == parse_tar_number( block + 148, 8 );
+}
+
+// get the path from pax extended header records, which have the form "<length> <key>=<value>\n"
+std::string pax_path( const std::string& data )
+{
+	std::string path;
+	for ( size_t pos = 0; pos < data.size(); )
+	{
+		auto space = data.find( ' ', pos );
+		if ( space == std::string::npos )
+			break;
+		auto len = std::stoul( data.substr( pos, space - pos ) );
+		if ( len == 0 || pos + len > data.size() )
+			break;
+		auto record = data.substr( space + 1, pos + len - space - 2 );
+		if ( record.compare( 0, 5, "path=" ) == 0 )
+			path = record.substr( 5 );
+		pos += len;
+	}
+	return path;
+}
+
+bool tar_reader::read_block( char* block )
+{
+	str_.read( block, tar_block_size );
+	return str_.gcount() == std::streamsize( tar_block_size );
+}
+
+void tar_reader::read_data( std::string& data, uint64_t size )
+{
+	data.resize( size );
+	str_.read( data.data(), std::streamsize( size ) );
+	xo_error_if( uint64_t( str_.gcount() ) != size, "Unexpected end of tar archive" );
+	skip_data( ( tar_block_size - size % tar_block_size ) % tar_block_size );
+}
+
+void tar_reader::skip_data( uint64_t size )
+{
+	char buf[ 4096 ];
+	while ( size > 0 )
+	{
+		auto n = std::min< uint64_t >( size, sizeof( buf ) );
+		str_.read( buf, std::streamsize( n ) );
+		xo_error_if( uint64_t( str_.gcount() ) != n, "Unexpected end of tar archive" );
+		size -= n;
+	}
+}
+
+bool tar_reader::next( std::string& name, std::string& contents, const std::function< bool( const std::string& ) >& select )
+{
+	std::string long_name;
+	char block[ tar_block_size ];
+	while ( read_block( block ) )
+	{
+		// the archive ends with zero blocks
+		if ( std::all_of( block, block + tar_block_size, []( char c ) { return c == 0; } ) )
+			return false;
+		xo_error_if( !valid_checksum( block ), "Invalid tar header checksum" );
+
+		auto size = parse_tar_number( block + 124, 12 );
+		auto type = block[ 156 ];
+		auto padded_size = ( size + tar_block_size - 1 ) / tar_block_size * tar_block_size;
+
+		if ( type == 'L' || type == 'x' )
+		{
+			// GNU long name or pax header, applies to the next entry
+			std::string data;
+			read_data( data, size );
+			long_name = type == 'L' ? tar_string( data.data(), data.size() ) : pax_path( data );
+			continue;
+		}
+		else if ( type != '0' && type != '\0' && type != '7' )
+		{
+			skip_data( padded_size );
+			long_name.clear();
+			continue;
+		}
+
+		name = long_name;
+		if ( name.empty() )
+		{
+			name = tar_string( block, 100 );
+			if ( memcmp( block + 257, "ustar", 5 ) == 0 && block[ 345 ] )
+				name = tar_string( block + 345, 155 ) + "/" + name;
+		}
+		long_name.clear();
+
+		if ( select( name ) )
+		{
+			read_data( contents, size );
+			return true;
+		}
+		else skip_data( padded_size );
+	}
+	return false;
+}
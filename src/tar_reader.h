@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <string>
+
+/// Reads regular file entries from an uncompressed tar stream (ustar, GNU and pax formats).
+/// The stream is read sequentially, so it can also be a pipe.
+class tar_reader
+{
+public:
+	explicit tar_reader( std::istream& str ) : str_( str ) {}
+
+	/// Read the next regular file for which select( name ) is true; the data of other entries is skipped.
+	/// Returns false at the end of the archive, throws if the archive is corrupt.
+	bool next( std::string& name, std::string& contents, const std::function< bool( const std::string& ) >& select );
+
+private:
+	bool read_block( char* block );
+	void read_data( std::string& data, uint64_t size );
+	void skip_data( uint64_t size );
+
+	std::istream& str_;
+};
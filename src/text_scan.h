@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#	define DOKUGEN_SSE2 1
+#	include <emmintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	endif
+#endif
+
+#ifdef DOKUGEN_SSE2
+inline int first_bit( unsigned int mask ) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward( &idx, mask );
+	return int( idx );
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+
+template< char... Chars > inline int match_mask( __m128i v ) {
+	__m128i m = _mm_setzero_si128();
+	( ( m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( Chars ) ) ) ), ... );
+	return _mm_movemask_epi8( m );
+}
+#endif
+
+template< char... Chars > inline bool is_one_of( char c ) { return ( ( c == Chars ) || ... ); }
+
+/// Returns a pointer to the first character in [begin, end) that is one of Chars, or end if there is none.
+/// Scans 16 bytes at a time where SSE2 is available, so clean spans can be copied in bulk.
+template< char... Chars > const char* scan_for( const char* begin, const char* end )
+{
+#ifdef DOKUGEN_SSE2
+	for ( ; end - begin >= 16; begin += 16 )
+		if ( int mask = match_mask< Chars... >( _mm_loadu_si128( reinterpret_cast<const __m128i*>( begin ) ) ) )
+			return begin + first_bit( mask );
+#endif
+	while ( begin != end && !is_one_of< Chars... >( *begin ) )
+		++begin;
+	return begin;
+}
@@ -0,0 +1,85 @@
+#include "watchdog.h"
+
+#include <algorithm>
+#include <utility>
+
+thread_local const std::atomic< bool >* current_cancel_flag = nullptr;
+
+void check_cancelled()
+{
+	if ( current_cancel_flag && current_cancel_flag->load( std::memory_order_relaxed ) )
+		throw conversion_timeout();
+}
+
+const std::atomic< bool >* cancel_flag()
+{
+	return current_cancel_flag;
+}
+
+void set_cancel_flag( const std::atomic< bool >* flag )
+{
+	current_cancel_flag = flag;
+}
+
+watchdog::watchdog( size_t num_workers, double time_budget ) :
+	time_budget_( std::chrono::duration_cast< clock::duration >( std::chrono::duration< double >( time_budget ) ) )
+{
+	for ( size_t i = 0; i < num_workers; ++i )
+		workers_.emplace_back( std::make_unique< worker_state >() );
+	if ( time_budget > 0 )
+		thread_ = std::thread( &watchdog::run, this );
+}
+
+watchdog::~watchdog()
+{
+	if ( thread_.joinable() )
+	{
+		{
+			std::lock_guard< std::mutex > lock( mutex_ );
+			stopping_ = true;
+		}
+		cv_.notify_all();
+		thread_.join();
+	}
+}
+
+void watchdog::start( size_t worker )
+{
+	auto& w = *workers_[ worker ];
+	{
+		std::lock_guard< std::mutex > lock( w.mutex );
+		w.cancelled = false;
+		w.start_ticks = std::max< int64_t >( clock::now().time_since_epoch().count(), 1 );
+	}
+	current_cancel_flag = &w.cancelled;
+}
+
+double watchdog::stop( size_t worker )
+{
+	auto& w = *workers_[ worker ];
+	int64_t start_ticks;
+	{
+		std::lock_guard< std::mutex > lock( w.mutex );
+		start_ticks = std::exchange( w.start_ticks, 0 );
+	}
+	auto start = clock::time_point( clock::duration( start_ticks ) );
+	current_cancel_flag = nullptr;
+	return std::chrono::duration< double >( clock::now() - start ).count();
+}
+
+void watchdog::run()
+{
+	// check often enough to cancel within a tenth of the budget
+	auto interval = std::clamp< clock::duration >( time_budget_ / 10, std::chrono::milliseconds( 1 ), std::chrono::milliseconds( 100 ) );
+	std::unique_lock< std::mutex > lock( mutex_ );
+	while ( !cv_.wait_for( lock, interval, [&]() { return stopping_; } ) )
+	{
+		auto now = clock::now().time_since_epoch().count();
+		for ( auto& w : workers_ )
+		{
+			std::lock_guard< std::mutex > worker_lock( w->mutex );
+			if ( w->start_ticks != 0 && clock::duration( now - w->start_ticks ) > time_budget_ )
+				w->cancelled = true;
+		}
+	}
+}
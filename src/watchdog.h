@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/// Thrown from a cancellation checkpoint when the conversion on the current thread has exceeded its time budget.
+struct conversion_timeout : public std::runtime_error
+{
+	conversion_timeout() : std::runtime_error( "conversion timed out" ) {}
+};
+
+/// Cancellation checkpoint for long running conversion steps, throws conversion_timeout if the watchdog
+/// has cancelled the conversion running on this thread. It's cheap enough to call per member.
+void check_cancelled();
+
+/// Cancellation flag of the current thread, helper threads take it over with set_cancel_flag() to share the time budget.
+const std::atomic< bool >* cancel_flag();
+void set_cancel_flag( const std::atomic< bool >* flag );
+
+/// Keeps track of how long each worker spends on its current file and cancels files that exceed the time budget.
+/// Cancellation is cooperative: a cancelled conversion stops at its next call to check_cancelled().
+class watchdog
+{
+public:
+	/// Create a watchdog for num_workers workers, a time budget of zero or less disables cancellation.
+	watchdog( size_t num_workers, double time_budget );
+	~watchdog();
+
+	/// Called by a worker when it starts on a file.
+	void start( size_t worker );
+
+	/// Called by a worker when it's done with a file, returns the elapsed time in seconds.
+	double stop( size_t worker );
+
+private:
+	using clock = std::chrono::steady_clock;
+	// start_ticks and cancelled change together under mutex, so a file is never cancelled
+	// for the time spent by the file before it
+	struct worker_state
+	{
+		std::mutex mutex;
+		int64_t start_ticks = 0; // zero when idle
+		std::atomic< bool > cancelled{ false };
+	};
+
+	void run();
+
+	std::vector< std::unique_ptr< worker_state > > workers_;
+	clock::duration time_budget_;
+	bool stopping_ = false;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::thread thread_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/// Bounded blocking queue for handing work from producer threads to worker threads.
+template< typename T > class work_queue
+{
+public:
+	explicit work_queue( size_t capacity ) : capacity_( capacity ) {}
+
+	/// Add an item, waits while the queue is full.
+	void push( T&& item ) {
+		std::unique_lock< std::mutex > lock( mutex_ );
+		not_full_.wait( lock, [&]() { return items_.size() < capacity_; } );
+		items_.push_back( std::move( item ) );
+		not_empty_.notify_one();
+	}
+
+	/// Get the next item, waits while the queue is empty; returns false when the queue is closed and empty.
+	bool pop( T& item ) {
+		std::unique_lock< std::mutex > lock( mutex_ );
+		not_empty_.wait( lock, [&]() { return !items_.empty() || closed_; } );
+		if ( items_.empty() )
+			return false;
+		item = std::move( items_.front() );
+		items_.pop_front();
+		not_full_.notify_one();
+		return true;
+	}
+
+	/// Signal that no more items will be pushed.
+	void close() {
+		std::lock_guard< std::mutex > lock( mutex_ );
+		closed_ = true;
+		not_empty_.notify_all();
+	}
+
+private:
+	size_t capacity_;
+	bool closed_ = false;
+	std::deque< T > items_;
+	std::mutex mutex_;
+	std::condition_variable not_full_;
+	std::condition_variable not_empty_;
+};
@@ -0,0 +1,131 @@
+#include "xml_text.h"
+#include "text_scan.h"
+#include <algorithm>
+
+void append_utf8( std::string& str, unsigned long code )
+{
+	if ( code < 0x80 )
+		str += char( code );
+	else if ( code < 0x800 ) {
+		str += char( 0xC0 | ( code >> 6 ) );
+		str += char( 0x80 | ( code & 0x3F ) );
+	}
+	else if ( code < 0x10000 ) {
+		str += char( 0xE0 | ( code >> 12 ) );
+		str += char( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+		str += char( 0x80 | ( code & 0x3F ) );
+	}
+	else if ( code < 0x110000 ) {
+		str += char( 0xF0 | ( code >> 18 ) );
+		str += char( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+		str += char( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+		str += char( 0x80 | ( code & 0x3F ) );
+	}
+}
+
+// decodes the reference at [p, end), where *p == '&'; returns the end of the reference or p if it's not a valid one
+const char* decode_reference( std::string& str, const char* p, const char* end )
+{
+	auto semicolon = static_cast<const char*>( memchr( p, ';', std::min<size_t>( end - p, 12 ) ) );
+	if ( !semicolon )
+		return p;
+
+	auto ent = p + 1;
+	auto len = semicolon - ent;
+	if ( len >= 2 && ent[ 0 ] == '#' )
+	{
+		unsigned long code = 0;
+		if ( ent[ 1 ] == 'x' || ent[ 1 ] == 'X' ) {
+			for ( auto c = ent + 2; c != semicolon; ++c ) {
+				if ( *c >= '0' && *c <= '9' ) code = code * 16 + ( *c - '0' );
+				else if ( *c >= 'a' && *c <= 'f' ) code = code * 16 + ( *c - 'a' + 10 );
+				else if ( *c >= 'A' && *c <= 'F' ) code = code * 16 + ( *c - 'A' + 10 );
+				else return p;
+			}
+			if ( len == 2 ) return p;
+		}
+		else {
+			for ( auto c = ent + 1; c != semicolon; ++c ) {
+				if ( *c >= '0' && *c <= '9' ) code = code * 10 + ( *c - '0' );
+				else return p;
+			}
+		}
+		append_utf8( str, code );
+		return semicolon + 1;
+	}
+
+	char c;
+	if ( len == 2 && ent[ 0 ] == 'l' && ent[ 1 ] == 't' ) c = '<';
+	else if ( len == 2 && ent[ 0 ] == 'g' && ent[ 1 ] == 't' ) c = '>';
+	else if ( len == 3 && !memcmp( ent, "amp", 3 ) ) c = '&';
+	else if ( len == 4 && !memcmp( ent, "quot", 4 ) ) c = '"';
+	else if ( len == 4 && !memcmp( ent, "apos", 4 ) ) c = '\'';
+	else return p;
+
+	str += c;
+	return semicolon + 1;
+}
+
+void append_decoded( std::string& str, const char* begin, const char* end )
+{
+	while ( begin != end )
+	{
+		// copy everything up to the next reference in one go
+		auto amp = scan_for< '&' >( begin, end );
+		str.append( begin, amp );
+		if ( amp == end )
+			break;
+
+		// unknown or malformed references are copied verbatim, like rapidxml does
+		auto next = decode_reference( str, amp, end );
+		if ( next == amp ) {
+			str += '&';
+			next = amp + 1;
+		}
+		begin = next;
+	}
+}
+
+bool has_empty_brief( const std::string& xml )
+{
+	// the compound brief comes after all sectiondefs and the compound templateparamlist,
+	// which both can contain briefdescriptions of their own
+	auto start = xml.find( "<compounddef" );
+	if ( start == std::string::npos )
+		return false;
+	for ( auto tag : { "</sectiondef>", "</templateparamlist>" } )
+		if ( auto pos = xml.rfind( tag ); pos != std::string::npos && pos > start )
+			start = pos;
+
+	const char brief_tag[] = "<briefdescription";
+	auto brief = xml.find( brief_tag, start );
+	if ( brief == std::string::npos )
+		return false;
+
+	auto p = xml.data() + brief + sizeof( brief_tag ) - 1;
+	auto end = xml.data() + xml.size();
+	p = scan_for< '>' >( p, end );
+	if ( p == end )
+		return false;
+	if ( p[ -1 ] == '/' )
+		return true; // <briefdescription/>
+
+	// only tags and whitespace until </briefdescription> means there is no text
+	for ( ++p; p != end; )
+	{
+		if ( *p == '<' )
+		{
+			if ( p + 1 != end && p[ 1 ] == '/' && !xml.compare( p - xml.data(), 19, "</briefdescription>" ) )
+				return true;
+			if ( p + 1 != end && p[ 1 ] == '!' )
+				return false; // CDATA or comment, let the parser decide
+			p = scan_for< '>' >( p, end );
+			if ( p != end )
+				++p;
+		}
+		else if ( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' )
+			++p;
+		else return false;
+	}
+	return false;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+
+/// Append XML text [begin, end) to str, expanding character and entity references.
+/// Text is copied in bulk up to each '&'; only the references themselves are decoded one by one.
+void append_decoded( std::string& str, const char* begin, const char* end );
+
+/// Decode XML text with character and entity references.
+inline std::string decode_text( const char* begin, const char* end ) {
+	std::string result;
+	result.reserve( end - begin );
+	append_decoded( result, begin, end );
+	return result;
+}
+inline std::string decode_text( const char* s ) { return decode_text( s, s + strlen( s ) ); }
+
+/// Check the raw XML of a compound for an empty compound-level briefdescription, without parsing it.
+/// Returns false if the brief has text or if it cannot be determined, in which case the file should be parsed.
+bool has_empty_brief( const std::string& xml );